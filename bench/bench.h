@@ -0,0 +1,18 @@
+#pragma once
+
+#include <chrono>
+
+namespace openapi::bench {
+
+// Mean wall time of one call of `fn` over `runs` calls, in milliseconds.
+template <typename Fn>
+double time_ms(unsigned const runs, Fn&& fn) {
+  auto const start = std::chrono::steady_clock::now();
+  for (auto i = 0U; i != runs; ++i) {
+    fn();
+  }
+  auto const d = std::chrono::steady_clock::now() - start;
+  return std::chrono::duration<double, std::milli>{d}.count() / runs;
+}
+
+}  // namespace openapi::bench
@@ -0,0 +1,35 @@
+#include "gtest/gtest.h"
+
+#include <iostream>
+#include <string>
+
+#include "cista/hash.h"
+
+#include "openapi/etag.h"
+
+#include "pet-api/pet-api.h"
+
+#include "bench.h"
+#include "pet_fixture.h"
+
+using namespace openapi;
+using namespace openapi::test;
+using openapi::bench::time_ms;
+
+TEST(bench, etag) {
+  constexpr auto const kRuns = 10U;
+
+  auto const items = make_items(100'000U);
+
+  auto tag = std::string{};
+  auto s = std::string{};
+  auto const hash_only =
+      time_ms(kRuns, [&] { tag = pet::getItems_response_etag(items); });
+  auto const serialize_and_hash = time_ms(kRuns, [&] {
+    s = pet::encode_getItems_response(items);
+    tag = etag(cista::hash(s));
+  });
+
+  std::cout << "etag: hash only " << hash_only << "ms, serialize+hash "
+            << serialize_and_hash << "ms (" << s.size() << " bytes)\n";
+}
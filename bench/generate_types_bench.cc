@@ -0,0 +1,44 @@
+#include "gtest/gtest.h"
+
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "boost/json.hpp"
+
+#include "events-api/events-api.h"
+
+#include "bench.h"
+
+namespace json = boost::json;
+using openapi::bench::time_ms;
+
+TEST(bench, variant_dispatch) {
+  constexpr auto const kRuns = 5U;
+  constexpr auto const kAlternatives = 12U;
+  constexpr auto const kEvents = 12'000U;
+
+  auto arr = json::array{};
+  for (auto i = 0U; i != kEvents; ++i) {
+    auto const k = i % kAlternatives;
+    arr.emplace_back(json::object{{"type", "Event" + std::to_string(k)},
+                                  {"value" + std::to_string(k), i}});
+  }
+  auto const jv = json::value{std::move(arr)};
+
+  auto tagged = std::vector<events::Event>{};
+  auto untagged = std::vector<events::UntaggedEvent>{};
+  auto const discriminator = time_ms(kRuns, [&] {
+    tagged = json::value_to<std::vector<events::Event>>(jv);
+  });
+  auto const trial = time_ms(kRuns, [&] {
+    untagged = json::value_to<std::vector<events::UntaggedEvent>>(jv);
+  });
+
+  ASSERT_EQ(kEvents, tagged.size());
+  ASSERT_EQ(kEvents, untagged.size());
+
+  std::cout << "variant: " << kEvents << " events, " << kAlternatives
+            << " alternatives, discriminator " << discriminator
+            << "ms, trial parsing " << trial << "ms\n";
+}
@@ -0,0 +1,45 @@
+#include "gtest/gtest.h"
+
+#include <cstddef>
+#include <iostream>
+
+#include "boost/json.hpp"
+
+#include "openapi/intern.h"
+#include "openapi/json.h"
+
+#include "transit-api/transit-api.h"
+
+#include "alloc_counter.h"
+#include "transit_fixture.h"
+
+using namespace openapi;
+
+TEST(bench, intern_memory) {
+  auto const jv = json::value_from(test::make_city_plan());
+
+  auto plain = transit::Plan{};
+  auto const without =
+      test::measure([&] { plain = json::value_to<transit::Plan>(jv); });
+
+  auto interned = transit::Plan{};
+  auto unique = std::size_t{0U};
+  auto hits = std::size_t{0U};
+  auto const with = test::measure([&] {
+    auto pool = intern_pool{};
+    auto const scope = intern_scope{pool};
+    interned = json::value_to<transit::Plan>(jv);
+    unique = pool.size();
+    hits = pool.hits_;
+  });
+
+  ASSERT_EQ(plain, interned);
+
+  std::cout << "intern: " << unique << " unique strings, " << hits
+            << " shared\n"
+            << "intern: decode allocated " << without.bytes_ << " bytes in "
+            << without.allocations_ << " allocations without pool, "
+            << with.bytes_ << " bytes in " << with.allocations_
+            << " allocations with pool ("
+            << 100U - with.bytes_ * 100U / without.bytes_ << "% less)\n";
+}
@@ -0,0 +1,44 @@
+#include "gtest/gtest.h"
+
+#include <iostream>
+#include <vector>
+
+#include "openapi/document.h"
+#include "openapi/json.h"
+
+#include "bench.h"
+
+using namespace openapi;
+using openapi::bench::time_ms;
+
+TEST(bench, read_numbers) {
+  constexpr auto const kRuns = 5U;
+  constexpr auto const kSize = 1'000'000U;
+
+  auto arr = json::array{};
+  arr.reserve(kSize);
+  for (auto i = 0U; i != kSize; ++i) {
+    arr.emplace_back(i % 2U == 0U ? json::value(i * 0.5) : json::value(i));
+  }
+  auto const jv = json::value{std::move(arr)};
+  auto const text = json::serialize(jv);
+
+  auto expected = std::vector<double>{};
+  auto read = std::vector<double>{};
+  auto parsed = std::vector<double>{};
+  auto const generic = time_ms(
+      kRuns, [&] { expected = json::value_to<std::vector<double>>(jv); });
+  auto const bulk = time_ms(kRuns, [&] { read_numbers(jv.as_array(), read); });
+  auto const dom = time_ms(
+      kRuns, [&] { read_numbers(json::parse(text).as_array(), read); });
+  auto const raw = time_ms(kRuns, [&] { parse_numbers(text, parsed); });
+
+  ASSERT_EQ(kSize, read.size());
+  EXPECT_EQ(expected, read);
+  EXPECT_EQ(expected, parsed);
+
+  std::cout << "read_numbers: " << kSize << " numbers, value_to " << generic
+            << "ms, read_numbers " << bulk << "ms\n"
+            << "from text: parse + read_numbers " << dom
+            << "ms, parse_numbers " << raw << "ms\n";
+}
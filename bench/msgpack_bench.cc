@@ -0,0 +1,71 @@
+#include "gtest/gtest.h"
+
+#include <iostream>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "boost/json.hpp"
+
+#include "openapi/msgpack.h"
+
+#include "pet-api/pet-api.h"
+#include "transit-api/transit-api.h"
+
+#include "bench.h"
+#include "pet_fixture.h"
+#include "transit_fixture.h"
+
+using namespace openapi;
+using namespace openapi::test;
+using openapi::bench::time_ms;
+namespace json = boost::json;
+
+namespace {
+
+// Sizes and encode / decode times of JSON and both msgpack key modes.
+template <typename T>
+void compare(std::string_view const name, T const& x, unsigned const runs) {
+  auto out = T{};
+  auto json_str = std::string{};
+  auto names = std::string{};
+  auto indices = std::string{};
+  auto const json_encode =
+      time_ms(runs, [&] { json_str = json::serialize(json::value_from(x)); });
+  auto const json_decode =
+      time_ms(runs, [&] { out = json::value_to<T>(json::parse(json_str)); });
+  auto const names_encode = time_ms(runs, [&] { names = to_msgpack(x); });
+  auto const names_decode = time_ms(runs, [&] { msgpack_into(out, names); });
+  auto const indices_encode = time_ms(
+      runs, [&] { indices = to_msgpack(x, msgpack_keys::kIndices); });
+  auto const indices_decode =
+      time_ms(runs, [&] { msgpack_into(out, indices); });
+
+  ASSERT_EQ(x, out);
+
+  std::cout << "msgpack " << name << ": json " << json_str.size()
+            << " bytes, encode " << json_encode << "ms, decode "
+            << json_decode << "ms\n"
+            << "msgpack " << name << ": names " << names.size()
+            << " bytes, encode " << names_encode << "ms, decode "
+            << names_decode << "ms\n"
+            << "msgpack " << name << ": indices " << indices.size()
+            << " bytes, encode " << indices_encode << "ms, decode "
+            << indices_decode << "ms\n";
+}
+
+}  // namespace
+
+TEST(bench, msgpack) {
+  compare("transit::Plan", make_plan(200U), 20U);
+
+  // Small structs with enums: keys and enum names dominate the JSON.
+  compare("pet::Item[]", make_items(100'000U), 5U);
+
+  // Maps: keys are data, msgpack_keys::kIndices does not shorten them.
+  auto shelf = pet::Shelf{};
+  for (auto i = 0; i != 100'000; ++i) {
+    shelf.counts_.emplace("item-" + std::to_string(i), i);
+  }
+  compare("pet::Shelf", shelf, 5U);
+}
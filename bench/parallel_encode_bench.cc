@@ -0,0 +1,40 @@
+#include "gtest/gtest.h"
+
+#include <algorithm>
+#include <iostream>
+#include <string>
+#include <thread>
+
+#include "boost/json.hpp"
+
+#include "openapi/parallel_encode.h"
+
+#include "bench.h"
+#include "pet_fixture.h"
+
+using namespace openapi;
+using namespace openapi::test;
+using openapi::bench::time_ms;
+namespace json = boost::json;
+
+TEST(bench, parallel_encode) {
+  constexpr auto const kRuns = 5U;
+
+  auto const items = make_items(200'000U);
+
+  auto expected = std::string{};
+  auto const serialize = time_ms(
+      kRuns, [&] { expected = json::serialize(json::value_from(items)); });
+  std::cout << "parallel_encode: " << items.size() << " items, serialize "
+            << serialize << "ms\n";
+
+  auto const max_threads = std::max(std::thread::hardware_concurrency(), 1U);
+  for (auto n = 1U; n <= max_threads; n *= 2U) {
+    auto pool = encode_pool{n};
+    auto s = std::string{};
+    std::cout << "parallel_encode: " << n << " threads "
+              << time_ms(kRuns, [&] { s = encode_array(items, pool); })
+              << "ms\n";
+    ASSERT_EQ(expected, s);
+  }
+}
@@ -0,0 +1,44 @@
+#include "gtest/gtest.h"
+
+#include <iostream>
+#include <optional>
+#include <string>
+
+#include "boost/json.hpp"
+
+#include "openapi/load_spec.h"
+#include "openapi/schema_vm.h"
+
+#include "transit-api/transit-api.h"
+
+#include "bench.h"
+#include "transit_fixture.h"
+
+using namespace openapi;
+using namespace openapi::test;
+using openapi::bench::time_ms;
+namespace json = boost::json;
+
+TEST(bench, schema_vm) {
+  constexpr auto const kRuns = 20U;
+
+  auto const spec = load_spec(OPENAPI_TEST_DIR "/transit.yml");
+  auto const program = compile_schema(spec, "Plan");
+  auto const str = json::serialize(json::value_from(make_plan(200U)));
+
+  auto plan = transit::Plan{};
+  auto out = std::string{};
+  auto error = std::optional<std::string>{};
+  auto const decode = time_ms(
+      kRuns, [&] { plan = json::value_to<transit::Plan>(json::parse(str)); });
+  auto const validated =
+      time_ms(kRuns, [&] { error = validate(program, str); });
+  auto const normalized =
+      time_ms(kRuns, [&] { out = normalize(program, str); });
+
+  ASSERT_EQ(std::nullopt, error);
+
+  std::cout << "schema_vm: " << str.size() << " bytes, generated decode "
+            << decode << "ms, vm validate " << validated
+            << "ms, vm normalize " << normalized << "ms\n";
+}
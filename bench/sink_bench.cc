@@ -0,0 +1,63 @@
+#include "gtest/gtest.h"
+
+#include <iostream>
+#include <string>
+
+#include "zlib.h"
+
+#include "openapi/sink.h"
+
+#include "pet-api/pet-api.h"
+
+#include "alloc_counter.h"
+#include "bench.h"
+#include "pet_fixture.h"
+
+using namespace openapi;
+using namespace openapi::test;
+using openapi::bench::time_ms;
+
+TEST(bench, sink) {
+  constexpr auto const kRuns = 5U;
+  constexpr auto const kBlockSize = 64U * 1024U;
+
+  auto const items = make_items(200'000U);
+
+  // Previous approach: full plaintext, then compress it.
+  auto const two_pass = [&] {
+    auto const plain = pet::encode_getItems_response(items);
+    auto bound = compressBound(static_cast<uLong>(plain.size()));
+    auto compressed = std::string(bound, '\0');
+    compress(reinterpret_cast<Bytef*>(compressed.data()), &bound,
+             reinterpret_cast<Bytef const*>(plain.data()),
+             static_cast<uLong>(plain.size()));
+    compressed.resize(bound);
+    return compressed;
+  };
+
+  auto const streaming = [&] {
+    auto compressed = std::string{};
+    auto out = string_sink{compressed};
+    auto z = zlib_sink{out, compression::kDeflate, -1, kBlockSize};
+    pet::encode_getItems_response(items, z);
+    z.finish();
+    return compressed;
+  };
+
+  auto compressed = std::string{};
+  auto streamed = std::string{};
+  auto const two_pass_ms = time_ms(kRuns, [&] { compressed = two_pass(); });
+  auto const streaming_ms = time_ms(kRuns, [&] { streamed = streaming(); });
+
+  // zlib's own state is allocated with malloc and not counted.
+  auto const two_pass_peak = measure([&] { two_pass(); }).peak_bytes_;
+  auto const streaming_peak = measure([&] { streaming(); }).peak_bytes_;
+
+  auto const plain_size = pet::encode_getItems_response(items).size();
+  std::cout << "sink: " << plain_size << " bytes json, " << streamed.size()
+            << " bytes compressed\n"
+            << "sink: serialize+compress " << two_pass_ms << "ms, peak "
+            << two_pass_peak << " bytes\n"
+            << "sink: zlib_sink " << streaming_ms << "ms, peak "
+            << streaming_peak << " bytes\n";
+}
@@ -1,19 +1,62 @@
+#include <filesystem>
 #include <fstream>
 #include <iostream>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
 
 #include "openapi/gen_types.h"
+#include "openapi/load_spec.h"
+
+namespace {
+
+// Make syntax: spaces and '#' escaped with '\', '$' doubled.
+std::string escape_make(std::string_view const path) {
+  auto out = std::string{};
+  for (auto const c : path) {
+    if (c == ' ' || c == '#') {
+      out += '\\';
+    } else if (c == '$') {
+      out += '$';
+    }
+    out += c;
+  }
+  return out;
+}
+
+}  // namespace
 
 int main(int argc, char** argv) {
   if (argc < 5) {
-    std::cout << "usage: openapi-generator [OPENAPI.YML] [/PATH/TO/HEADER.h] "
+    std::cout << "usage: openapi-generator [OPENAPI.YML|OPENAPI.JSON] "
+                 "[/PATH/TO/HEADER.h] "
                  "[/PATH/TO/SOURCE.cc] "
-                 "[NAMESPACE]\n";
+                 "[NAMESPACE] "
+                 "[CACHE_DIR (optional, may be empty)] "
+                 "[DEPFILE (optional)]\n";
     return 1;
   }
 
-  auto const root = YAML::LoadFile(argv[1]);
+  auto deps = std::vector<std::filesystem::path>{};
+  auto const root = openapi::load_spec(
+      argv[1],
+      argc > 5 && *argv[5] != '\0'
+          ? std::optional<std::filesystem::path>{argv[5]}
+          : std::nullopt,
+      &deps);
   auto header = std::ofstream{argv[2]};
   auto source = std::ofstream{argv[3]};
   openapi::write_types(root, argv[2], header, source,
                        std::string_view{argv[4]});
-}
\ No newline at end of file
+
+  // Referenced spec files for the build system (CMake DEPFILE).
+  if (argc > 6) {
+    auto depfile = std::ofstream{argv[6]};
+    depfile << escape_make(argv[2]) << ':';
+    for (auto const& d : deps) {
+      depfile << " \\\n  " << escape_make(d.string());
+    }
+    depfile << '\n';
+  }
+}
@@ -0,0 +1,147 @@
+#pragma once
+
+#include <compare>
+#include <concepts>
+#include <cstdint>
+#include <limits>
+#include <optional>
+#include <type_traits>
+
+#include "boost/json/value.hpp"
+#include "boost/json/value_from.hpp"
+#include "boost/json/value_to.hpp"
+
+#include "utl/verify.h"
+
+namespace openapi {
+
+// Storage and empty marker of a compact_optional<T>.
+template <typename T>
+struct compact_traits;
+
+template <>
+struct compact_traits<bool> {
+  using storage_t = std::uint8_t;
+  static constexpr storage_t kEmpty = 2U;
+  static constexpr bool is_empty(storage_t const s) { return s == kEmpty; }
+  static constexpr storage_t store(bool const v) { return v ? 1U : 0U; }
+  static constexpr bool load(storage_t const s) { return s == 1U; }
+};
+
+template <std::integral T>
+  requires(!std::same_as<T, bool>)
+struct compact_traits<T> {
+  using storage_t = T;
+  static constexpr storage_t kEmpty = std::is_signed_v<T>
+                                          ? std::numeric_limits<T>::min()
+                                          : std::numeric_limits<T>::max();
+  static constexpr bool is_empty(storage_t const s) { return s == kEmpty; }
+  static constexpr storage_t store(T const v) { return v; }
+  static constexpr T load(storage_t const s) { return s; }
+};
+
+// JSON has no NaN, so NaN is free to mark the empty state.
+template <std::floating_point T>
+struct compact_traits<T> {
+  using storage_t = T;
+  static constexpr storage_t kEmpty = std::numeric_limits<T>::quiet_NaN();
+  static constexpr bool is_empty(storage_t const s) { return s != s; }
+  static constexpr storage_t store(T const v) { return v; }
+  static constexpr T load(storage_t const s) { return s; }
+};
+
+template <typename T>
+  requires std::is_enum_v<T>
+struct compact_traits<T> {
+  using storage_t = std::underlying_type_t<T>;
+  static constexpr storage_t kEmpty = std::numeric_limits<storage_t>::max();
+  static constexpr bool is_empty(storage_t const s) { return s == kEmpty; }
+  static constexpr storage_t store(T const v) {
+    return static_cast<storage_t>(v);
+  }
+  static constexpr T load(storage_t const s) { return static_cast<T>(s); }
+};
+
+// Optional without a separate engaged flag: the empty state is a reserved
+// value of the storage type (see compact_traits). Used for optional scalar
+// and enum members of schemas with `x-compact: true`.
+// Values are returned by value, assign to change them.
+template <typename T>
+struct compact_optional {
+  using value_type = T;
+  using traits = compact_traits<T>;
+  using storage_t = typename traits::storage_t;
+
+  constexpr compact_optional() = default;
+  constexpr compact_optional(std::nullopt_t) {}
+
+  compact_optional(T const v) : v_{traits::store(v)} {
+    utl::verify(!traits::is_empty(v_),
+                "compact_optional: value reserved for the empty state");
+  }
+
+  compact_optional(std::optional<T> const& o) {
+    if (o.has_value()) {
+      *this = *o;
+    }
+  }
+
+  constexpr bool has_value() const { return !traits::is_empty(v_); }
+  constexpr explicit operator bool() const { return has_value(); }
+
+  constexpr T operator*() const { return traits::load(v_); }
+
+  T value() const {
+    utl::verify(has_value(), "compact_optional: no value");
+    return traits::load(v_);
+  }
+
+  constexpr T value_or(T const fallback) const {
+    return has_value() ? traits::load(v_) : fallback;
+  }
+
+  constexpr void reset() { v_ = traits::kEmpty; }
+
+  constexpr std::optional<T> to_optional() const {
+    return has_value() ? std::optional{traits::load(v_)} : std::nullopt;
+  }
+
+  friend constexpr bool operator==(compact_optional const& a,
+                                   compact_optional const& b) {
+    return a.has_value() == b.has_value() && (!a.has_value() || *a == *b);
+  }
+
+  friend constexpr bool operator==(compact_optional const& a, std::nullopt_t) {
+    return !a.has_value();
+  }
+
+  // Same order as std::optional: empty < any value.
+  friend constexpr std::compare_three_way_result_t<T> operator<=>(
+      compact_optional const& a, compact_optional const& b) {
+    if (a.has_value() && b.has_value()) {
+      return *a <=> *b;
+    }
+    return a.has_value() <=> b.has_value();
+  }
+
+  friend void tag_invoke(boost::json::value_from_tag,
+                         boost::json::value& jv,
+                         compact_optional const& o) {
+    if (o.has_value()) {
+      boost::json::value_from(*o, jv);
+    } else {
+      jv = nullptr;
+    }
+  }
+
+  friend compact_optional tag_invoke(
+      boost::json::value_to_tag<compact_optional>,
+      boost::json::value const& jv) {
+    return jv.is_null() ? compact_optional{}
+                        : compact_optional{boost::json::value_to<T>(jv)};
+  }
+
+  storage_t v_{traits::kEmpty};
+};
+
+}  // namespace openapi
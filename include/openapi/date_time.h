@@ -1,31 +1,71 @@
 #pragma once
 
 #include <chrono>
+#include <cstdint>
 #include <iosfwd>
+#include <string>
+#include <string_view>
 
 namespace openapi {
 
+// Point in time with millisecond precision plus the UTC offset it was given
+// in, packed into one 64 bit word: epoch milliseconds in the upper 52 bits
+// (+-71000 years), offset in minutes (biased, +-2047) in the lower 12 bits.
+// Comparison and hashing work on the word: ordered by time, then offset.
+// The packed word is an in-memory format only, codecs write time and offset.
+//
+// API change: the former public members `time_` (sys_seconds) and `offset_`
+// are gone. Read them via time() / offset() (or *t, t-> for seconds), assign
+// a new offset_time to change them.
 struct offset_time {
+  static constexpr auto const kOffsetBits = 12U;
+  static constexpr auto const kOffsetBias = std::int64_t{1}
+                                            << (kOffsetBits - 1U);
+  static constexpr auto const kOffsetMask =
+      (std::int64_t{1} << kOffsetBits) - 1;
+
   offset_time() = default;
 
-  template <typename Period>
+  template <typename Duration>
   offset_time(
-      std::chrono::time_point<std::chrono::system_clock, Period> const t,
+      std::chrono::time_point<std::chrono::system_clock, Duration> const t,
       std::chrono::minutes const offset = std::chrono::minutes{0})
-      : offset_{offset},
-        time_{std::chrono::time_point_cast<std::chrono::minutes>(t)} {}
+      : bits_{pack(std::chrono::floor<std::chrono::milliseconds>(t),
+                   offset)} {}
 
   friend std::ostream& operator<<(std::ostream&, offset_time const&);
 
-  operator std::chrono::sys_seconds() const { return time_; }
-  std::chrono::sys_seconds operator*() const { return time_; }
-  std::chrono::sys_seconds* operator->() { return &time_; }
-  std::chrono::sys_seconds const* operator->() const { return &time_; }
+  // UTC time point.
+  std::chrono::sys_time<std::chrono::milliseconds> time() const {
+    return std::chrono::sys_time<std::chrono::milliseconds>{
+        std::chrono::milliseconds{bits_ >> kOffsetBits}};
+  }
+
+  std::chrono::minutes offset() const {
+    return std::chrono::minutes{(bits_ & kOffsetMask) - kOffsetBias};
+  }
+
+  struct arrow_proxy {
+    std::chrono::sys_seconds const* operator->() const { return &t_; }
+    std::chrono::sys_seconds t_;
+  };
+
+  operator std::chrono::sys_seconds() const {
+    return std::chrono::floor<std::chrono::seconds>(time());
+  }
+  std::chrono::sys_seconds operator*() const {
+    return std::chrono::floor<std::chrono::seconds>(time());
+  }
+  arrow_proxy operator->() const { return {**this}; }
+
+  std::uint64_t hash() const { return static_cast<std::uint64_t>(bits_); }
 
   auto operator<=>(offset_time const&) const = default;
 
-  std::chrono::minutes offset_{0U};
-  std::chrono::sys_seconds time_{std::chrono::seconds{0U}};
+  static std::int64_t pack(std::chrono::sys_time<std::chrono::milliseconds>,
+                           std::chrono::minutes offset);
+
+  std::int64_t bits_{kOffsetBias};
 };
 
 using date_time_t = offset_time;
@@ -34,4 +74,7 @@ date_time_t now();
 
 void parse(std::string_view, date_time_t&);
 
-}  // namespace openapi
\ No newline at end of file
+// ISO 8601: local time of the offset (fraction only if non-zero) + offset.
+std::string to_str(date_time_t);
+
+}  // namespace openapi
@@ -0,0 +1,222 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <exception>
+#include <optional>
+#include <span>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <vector>
+
+#include "boost/json/kind.hpp"
+#include "boost/json/monotonic_resource.hpp"
+#include "boost/json/value.hpp"
+
+#include "openapi/compact_optional.h"
+#include "openapi/json.h"
+
+namespace openapi {
+
+// A JSON text as flat sequence of values in document order, produced by a
+// boost::json::basic_parser handler without building a DOM. Strings and keys
+// without escapes view into the input, escaped ones are unescaped into the
+// arena. Arrays and objects store their element / member count and the
+// index past their last token (for skip()). Keys are strings with key_ set.
+// Arrays of numbers have no element tokens: numbers_ is set and their
+// elements are stored as doubles in json_tokens::numbers_, from first_ on.
+struct json_token {
+  json::kind kind_{json::kind::null};
+  bool key_{false};
+  bool numbers_{false};
+  std::string_view str_{};
+  std::int64_t i_{0};
+  std::uint64_t u_{0U};
+  double d_{0.0};
+  bool b_{false};
+  std::size_t size_{0U};
+  std::size_t end_{0U};
+  std::size_t first_{0U};
+};
+
+struct json_tokens {
+  std::vector<json_token> tokens_;
+  // Elements of number arrays. Integers (only up to 2^53, larger ones make
+  // the array a regular one) are marked to restore them in read_value().
+  std::vector<double> numbers_;
+  std::vector<bool> integers_;
+};
+
+// Throws on invalid JSON. `in` and `arena` have to outlive the tokens.
+json_tokens parse_tokens(std::string_view in, json::monotonic_resource& arena);
+
+// Pull reader over the tokens, mirrors msgpack_reader.
+struct json_token_reader {
+  std::string_view read_string();  // points into the input or arena
+  // Member / element count.
+  std::size_t read_object();
+  std::size_t read_array();
+
+  // Number arrays are copied in one step, other arrays are checked
+  // element by element like read_numbers(json::array const&, ...).
+  void read_numbers(std::vector<double>&);
+
+  // Index of the key in `names`, names.size() for unknown keys (kept in
+  // unknown_key_ for additionalProperties).
+  std::uint32_t read_key(std::span<std::string_view const> names);
+
+  // Copy of the next value, allocated in the arena.
+  json::value read_value();
+
+  void skip();
+
+  json_tokens const& in_;
+  json::storage_ptr storage_;
+  std::size_t pos_{0U};
+
+  // Inside a number array: next element in in_.numbers_, elements left.
+  std::size_t number_{0U};
+  std::size_t numbers_left_{0U};
+
+  std::string_view unknown_key_{};
+};
+
+// Decoding from tokens, generated types with borrowed strings or number
+// arrays provide json_read as hidden friend. Other members are copied into a
+// json::value and decoded with decode_into.
+//
+// Types with borrowed (`x-cpp-borrow`) std::string_view members: their
+// value_to, decode_into, patch_into and msgpack_read are deleted, the views
+// would outlive the DOM / buffer they point into. document<T> below is the
+// only way to decode them.
+//
+// Types with `type: array, items: {type: number}` members: read_json parses
+// the elements straight into doubles, no json::value is built for them.
+template <class T>
+void json_read(json_token_reader&, T&);
+inline void json_read(json_token_reader&, std::string_view&);
+inline void json_read(json_token_reader&, std::vector<double>&);
+template <class T>
+void json_read(json_token_reader&, std::vector<T>&);
+template <class T>
+void json_read(json_token_reader&, std::optional<T>&);
+
+template <class T>
+void json_read(json_token_reader& r, T& t) {
+  decode_into(t, r.read_value());
+}
+
+inline void json_read(json_token_reader& r, std::string_view& s) {
+  s = r.read_string();
+}
+
+inline void json_read(json_token_reader& r, std::vector<double>& v) {
+  r.read_numbers(v);
+}
+
+template <class T>
+void json_read(json_token_reader& r, std::vector<T>& v) {
+  if constexpr (std::is_same_v<T, bool>) {
+    decode_into(v, r.read_value());
+  } else {
+    v.resize(r.read_array());
+    auto i = std::size_t{0U};
+    try {
+      for (; i != v.size(); ++i) {
+        json_read(r, v[i]);
+      }
+    } catch (std::exception const& e) {
+      rethrow_at(i, e);
+    }
+  }
+}
+
+template <class T>
+void json_read(json_token_reader& r, std::optional<T>& t) {
+  json_read(r, t.has_value() ? *t : t.emplace());
+}
+
+template <class T>
+void json_read_member(json_token_reader& r,
+                      T& t,
+                      std::string_view const key) {
+  try {
+    json_read(r, t);
+  } catch (std::exception const& e) {
+    rethrow_at(key, e);
+  }
+}
+
+// Value of the unknown key just read, into the additionalProperties map.
+template <class Map>
+void json_read_additional(json_token_reader& r, Map& m) {
+  auto const key = r.unknown_key_;
+  json_read_member(r, m[std::string{key}], key);
+}
+
+template <class T>
+void json_missing(T&, std::string_view const key) {
+  throw utl::fail("/: missing property {}", key);
+}
+
+template <class T>
+void json_missing(std::optional<T>& t, std::string_view) {
+  t.reset();
+}
+
+template <class T>
+void json_missing(compact_optional<T>& t, std::string_view) {
+  t.reset();
+}
+
+template <class T>
+void read_json_into(T& t, std::string_view const s) {
+  auto arena = json::monotonic_resource{};
+  auto const tokens = parse_tokens(s, arena);
+  auto r = json_token_reader{.in_ = tokens, .storage_ = &arena};
+  json_read(r, t);
+}
+
+template <class T>
+T read_json(std::string_view const s) {
+  auto t = T{};
+  read_json_into(t, s);
+  return t;
+}
+
+// Raw JSON text of a number array -> vector, without a json::array.
+void parse_numbers(std::string_view, std::vector<double>&);
+
+// Decoded value of a type with borrowed members together with the JSON text
+// the views point into. The input is copied once into buffer_. Strings
+// without escapes are views into buffer_, only escaped strings (and members
+// without borrowed strings, which are decoded through a json::value) are
+// copied into the arena. No DOM of the whole document is built.
+// Neither copyable nor movable: buffer_ may store short inputs inline,
+// moving the document would invalidate the views.
+template <typename T>
+struct document {
+  explicit document(std::string_view s) : buffer_{s} {
+    auto const tokens = parse_tokens(buffer_, arena_);
+    auto r = json_token_reader{.in_ = tokens, .storage_ = &arena_};
+    json_read(r, value_);
+  }
+
+  document(document const&) = delete;
+  document(document&&) = delete;
+  document& operator=(document const&) = delete;
+  document& operator=(document&&) = delete;
+
+  ~document() = default;
+
+  T const& operator*() const { return value_; }
+  T const* operator->() const { return &value_; }
+  T const& get() const { return value_; }
+
+  std::string buffer_;
+  json::monotonic_resource arena_;
+  T value_{};
+};
+
+}  // namespace openapi
@@ -0,0 +1,135 @@
+#pragma once
+
+#include <bit>
+#include <cstdint>
+#include <initializer_list>
+#include <iterator>
+#include <ostream>
+#include <string_view>
+#include <type_traits>
+
+#include "boost/json/value.hpp"
+#include "boost/json/value_from.hpp"
+#include "boost/json/value_to.hpp"
+
+namespace openapi {
+
+// Fixed width bitset over the values of a generated enum with N values.
+// Replaces std::vector<Enum> for `type: array` schemas with `x-enum-set: true`.
+template <typename E, std::size_t N>
+  requires(std::is_enum_v<E> && N <= 64U)
+struct enum_set {
+  using storage_t = std::conditional_t<
+      N <= 8U,
+      std::uint8_t,
+      std::conditional_t<
+          N <= 16U,
+          std::uint16_t,
+          std::conditional_t<N <= 32U, std::uint32_t, std::uint64_t>>>;
+
+  struct iterator {
+    using iterator_category = std::forward_iterator_tag;
+    using value_type = E;
+    using difference_type = std::ptrdiff_t;
+    using pointer = E const*;
+    using reference = E;
+
+    constexpr E operator*() const {
+      return static_cast<E>(std::countr_zero(bits_));
+    }
+
+    constexpr iterator& operator++() {
+      bits_ &= static_cast<storage_t>(bits_ - 1U);
+      return *this;
+    }
+
+    constexpr iterator operator++(int) {
+      auto tmp = *this;
+      ++(*this);
+      return tmp;
+    }
+
+    constexpr bool operator==(iterator const&) const = default;
+
+    storage_t bits_{0U};
+  };
+
+  constexpr enum_set() = default;
+
+  constexpr enum_set(std::initializer_list<E> init) {
+    for (auto const e : init) {
+      insert(e);
+    }
+  }
+
+  static constexpr storage_t bit(E const e) {
+    return static_cast<storage_t>(storage_t{1U}
+                                  << static_cast<std::size_t>(e));
+  }
+
+  constexpr void insert(E const e) { bits_ |= bit(e); }
+  constexpr void erase(E const e) { bits_ &= static_cast<storage_t>(~bit(e)); }
+  constexpr void clear() { bits_ = 0U; }
+
+  constexpr bool contains(E const e) const { return (bits_ & bit(e)) != 0U; }
+  constexpr bool empty() const { return bits_ == 0U; }
+  constexpr std::size_t size() const {
+    return static_cast<std::size_t>(std::popcount(bits_));
+  }
+
+  constexpr iterator begin() const { return iterator{bits_}; }
+  constexpr iterator end() const { return iterator{}; }
+
+  constexpr std::uint64_t hash() const { return bits_; }
+
+  constexpr auto operator<=>(enum_set const&) const = default;
+
+  friend std::ostream& operator<<(std::ostream& out, enum_set const& s) {
+    auto first = true;
+    for (auto const e : s) {
+      if (!first) {
+        out << ",";
+      }
+      first = false;
+      out << e;
+    }
+    return out;
+  }
+
+  // Query parameter codec: comma separated list of enum values.
+  // Uses the parse(std::string_view, E&) generated next to the enum.
+  friend void parse(std::string_view s, enum_set& v) {
+    v.clear();
+    while (!s.empty()) {
+      auto const pos = s.find(',');
+      auto e = E{};
+      parse(s.substr(0U, pos), e);
+      v.insert(e);
+      s = pos == std::string_view::npos ? std::string_view{}
+                                        : s.substr(pos + 1U);
+    }
+  }
+
+  friend void tag_invoke(boost::json::value_from_tag,
+                         boost::json::value& jv,
+                         enum_set const& s) {
+    auto& arr = jv.emplace_array();
+    arr.reserve(s.size());
+    for (auto const e : s) {
+      arr.emplace_back(boost::json::value_from(e));
+    }
+  }
+
+  friend enum_set tag_invoke(boost::json::value_to_tag<enum_set>,
+                             boost::json::value const& jv) {
+    auto s = enum_set{};
+    for (auto const& x : jv.as_array()) {
+      s.insert(boost::json::value_to<E>(x));
+    }
+    return s;
+  }
+
+  storage_t bits_{0U};
+};
+
+}  // namespace openapi
@@ -0,0 +1,183 @@
+#pragma once
+
+#include <bit>
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <variant>
+#include <vector>
+
+#include "boost/json/value.hpp"
+#include "boost/unordered/unordered_flat_map.hpp"
+
+#include "cista/hash.h"
+
+#include "openapi/compact_optional.h"
+#include "openapi/date_time.h"
+#include "openapi/enum_set.h"
+#include "openapi/intern.h"
+#include "openapi/ordered_map.h"
+
+namespace openapi {
+
+// Content hash of generated types for ETags (If-None-Match -> 304).
+// Computed from the values (FNV-1a via cista::hash), not from the encoded
+// JSON: hash_of neither serializes nor allocates, only etag() formats the
+// header value. Equal values of a type have the same hash: unordered maps and
+// JSON objects independent of member order, integers in a boost::json::value
+// independent of int64 / uint64 storage.
+struct content_hash {
+  void update(std::uint64_t const x) {
+    h_ = cista::hash({reinterpret_cast<char const*>(&x), sizeof(x)}, h_);
+  }
+
+  // Length prefixed, "ab","c" != "a","bc".
+  void update(std::string_view const s) {
+    update(static_cast<std::uint64_t>(s.size()));
+    h_ = cista::hash(s, h_);
+  }
+
+  cista::hash_t h_{cista::BASE_HASH};
+};
+
+// Types without generated hash_value. Generated structs provide it as a
+// hidden friend (found by ADL), enums and variants use the overloads below.
+template <typename T>
+  requires(std::is_arithmetic_v<T> || std::is_enum_v<T>)
+void hash_value(content_hash&, T);
+inline void hash_value(content_hash&, std::string const&);
+inline void hash_value(content_hash&, std::string_view);
+inline void hash_value(content_hash&, interned_string const&);
+inline void hash_value(content_hash&, date_time_t);
+void hash_value(content_hash&, boost::json::value const&);
+template <typename T>
+void hash_value(content_hash&, std::vector<T> const&);
+template <typename T>
+void hash_value(content_hash&, std::optional<T> const&);
+template <typename T>
+void hash_value(content_hash&, compact_optional<T> const&);
+template <typename T>
+void hash_value(content_hash&,
+                boost::unordered_flat_map<std::string, T> const&);
+template <typename T>
+void hash_value(content_hash&, ordered_map<T> const&);
+template <typename E, std::size_t N>
+void hash_value(content_hash&, enum_set<E, N> const&);
+template <typename... T>
+void hash_value(content_hash&, std::variant<T...> const&);
+
+template <typename T>
+  requires(std::is_arithmetic_v<T> || std::is_enum_v<T>)
+void hash_value(content_hash& h, T const x) {
+  if constexpr (std::is_enum_v<T>) {
+    h.update(static_cast<std::uint64_t>(x));
+  } else if constexpr (std::is_floating_point_v<T>) {
+    h.update(std::bit_cast<std::uint64_t>(static_cast<double>(x)));
+  } else {
+    h.update(static_cast<std::uint64_t>(x));
+  }
+}
+
+inline void hash_value(content_hash& h, std::string const& s) { h.update(s); }
+
+inline void hash_value(content_hash& h, std::string_view const s) {
+  h.update(s);
+}
+
+inline void hash_value(content_hash& h, interned_string const& s) {
+  h.update(s.view());
+}
+
+inline void hash_value(content_hash& h, date_time_t const t) {
+  h.update(static_cast<std::uint64_t>(t.bits_));
+}
+
+template <typename T>
+void hash_value(content_hash& h, std::vector<T> const& v) {
+  h.update(static_cast<std::uint64_t>(v.size()));
+  for (auto const& x : v) {
+    hash_value(h, x);
+  }
+}
+
+template <typename T>
+void hash_value(content_hash& h, std::optional<T> const& t) {
+  h.update(std::uint64_t{t.has_value()});
+  if (t.has_value()) {
+    hash_value(h, *t);
+  }
+}
+
+template <typename T>
+void hash_value(content_hash& h, compact_optional<T> const& t) {
+  h.update(std::uint64_t{t.has_value()});
+  if (t.has_value()) {
+    hash_value(h, *t);
+  }
+}
+
+// Entries are hashed separately and summed: iteration order is unspecified.
+template <typename T>
+void hash_value(content_hash& h,
+                boost::unordered_flat_map<std::string, T> const& m) {
+  auto sum = std::uint64_t{0U};
+  for (auto const& [k, v] : m) {
+    auto entry = content_hash{};
+    entry.update(k);
+    hash_value(entry, v);
+    sum += entry.h_;
+  }
+  h.update(static_cast<std::uint64_t>(m.size()));
+  h.update(sum);
+}
+
+template <typename T>
+void hash_value(content_hash& h, ordered_map<T> const& m) {
+  h.update(static_cast<std::uint64_t>(m.size()));
+  for (auto const& [k, v] : m) {
+    h.update(k);
+    hash_value(h, v);
+  }
+}
+
+template <typename E, std::size_t N>
+void hash_value(content_hash& h, enum_set<E, N> const& s) {
+  h.update(s.hash());
+}
+
+template <typename... T>
+void hash_value(content_hash& h, std::variant<T...> const& v) {
+  h.update(static_cast<std::uint64_t>(v.index()));
+  std::visit([&](auto const& x) { hash_value(h, x); }, v);
+}
+
+// Called by generated code: unqualified call, so ADL finds hidden friends.
+template <typename T>
+void hash_member(content_hash& h, T const& t) {
+  hash_value(h, t);
+}
+
+template <typename T>
+cista::hash_t hash_of(T const& t) {
+  auto h = content_hash{};
+  hash_value(h, t);
+  return h.h_;
+}
+
+// Weak ETag header value: W/"0123456789abcdef". Weak because the hash covers
+// the values, not the bytes: JSON, msgpack and gzip / deflate encodings of a
+// response share it (RFC 9110 8.8.1). Enough for If-None-Match, not for
+// If-Match or Range requests.
+std::string etag(cista::hash_t);
+
+template <typename T>
+std::string etag_of(T const& t) {
+  return etag(hash_of(t));
+}
+
+// If-None-Match: "*" or a list of (possibly weak) entity tags.
+bool etag_matches(std::string_view if_none_match, std::string_view etag);
+
+}  // namespace openapi
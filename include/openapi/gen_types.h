@@ -21,13 +21,23 @@ enum class type {
   kString,
   kArray,
   kObject,
-  kDate
+  kDate,
+  kVariant
 };
 
 type to_type(YAML::Node const& schema);
 
 std::string_view to_cpp(type const);
 
+// Schema helpers shared with the runtime schema VM.
+bool has_type(YAML::Node const& schema);
+YAML::Node get_alternatives(YAML::Node const& schema);
+std::string_view get_number_type(YAML::Node const& schema);
+std::string_view ref_name(YAML::Node const& ref);
+YAML::Node resolve_schema(YAML::Node const& root, YAML::Node const& schema);
+bool is_map(YAML::Node const& schema);
+YAML::Node flatten_all_of(YAML::Node const& root, YAML::Node const& schema);
+
 bool gen_enum(std::string_view name, YAML::Node const& schema, std::ostream&);
 
 std::string get_type(YAML::Node const& root,
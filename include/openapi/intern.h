@@ -0,0 +1,95 @@
+#pragma once
+
+#include <compare>
+#include <cstddef>
+#include <functional>
+#include <memory>
+#include <ostream>
+#include <string>
+#include <string_view>
+
+#include "boost/json/value.hpp"
+#include "boost/json/value_from.hpp"
+#include "boost/json/value_to.hpp"
+#include "boost/unordered/unordered_flat_map.hpp"
+
+namespace openapi {
+
+// Deduplicates strings: equal values share one immutable std::string.
+// Not thread safe, use one pool per document or per thread.
+struct intern_pool {
+  std::shared_ptr<std::string const> get(std::string_view);
+
+  std::size_t size() const { return strings_.size(); }
+  void clear();
+
+  boost::unordered_flat_map<std::string_view,
+                            std::shared_ptr<std::string const>,
+                            std::hash<std::string_view>>
+      strings_;
+  std::size_t hits_{0U};
+};
+
+// Makes the pool the current one of this thread while alive (e.g. during
+// decoding), restores the previous one afterwards.
+struct intern_scope {
+  explicit intern_scope(intern_pool&);
+  ~intern_scope();
+
+  intern_scope(intern_scope const&) = delete;
+  intern_scope(intern_scope&&) = delete;
+  intern_scope& operator=(intern_scope const&) = delete;
+  intern_scope& operator=(intern_scope&&) = delete;
+
+  intern_pool* prev_;
+};
+
+intern_pool* current_intern_pool();
+
+// Immutable string member for properties with `x-intern: true`.
+// Values created while an intern_scope is active share their storage with
+// all equal values of the pool, otherwise they are allocated individually.
+struct interned_string {
+  interned_string() = default;
+  interned_string(std::string_view);
+  interned_string(char const* s) : interned_string{std::string_view{s}} {}
+  interned_string(std::string const& s)
+      : interned_string{std::string_view{s}} {}
+
+  std::string_view view() const {
+    return p_ == nullptr ? std::string_view{} : std::string_view{*p_};
+  }
+  operator std::string_view() const { return view(); }
+
+  bool empty() const { return view().empty(); }
+  std::size_t size() const { return view().size(); }
+  char const* data() const { return view().data(); }
+
+  friend bool operator==(interned_string const& a, interned_string const& b) {
+    return a.p_ == b.p_ || a.view() == b.view();
+  }
+
+  friend std::strong_ordering operator<=>(interned_string const& a,
+                                          interned_string const& b) {
+    return a.view() <=> b.view();
+  }
+
+  friend std::ostream& operator<<(std::ostream& out, interned_string const& s) {
+    return out << s.view();
+  }
+
+  friend void tag_invoke(boost::json::value_from_tag,
+                         boost::json::value& jv,
+                         interned_string const& s) {
+    jv.emplace_string() = s.view();
+  }
+
+  friend interned_string tag_invoke(boost::json::value_to_tag<interned_string>,
+                                    boost::json::value const& jv) {
+    return interned_string{std::string_view{jv.as_string()}};
+  }
+
+  std::shared_ptr<std::string const> p_;
+};
+
+}  // namespace openapi
@@ -1,10 +1,23 @@
 #pragma once
 
+#include <algorithm>
+#include <cmath>
+#include <exception>
+#include <optional>
+#include <span>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <vector>
+
 #include "boost/json.hpp"
+#include "boost/unordered/unordered_flat_map.hpp"
 
 #include "utl/verify.h"
 
+#include "openapi/compact_optional.h"
 #include "openapi/date_time.h"
+#include "openapi/ordered_map.h"
 
 namespace openapi {
 
@@ -13,14 +26,146 @@ namespace json = boost::json;
 date_time_t tag_invoke(json::value_to_tag<date_time_t>, json::value const&);
 void tag_invoke(json::value_from_tag, json::value&, date_time_t const);
 
+// Decoding errors start with the JSON pointer of the offending value:
+// "/legs/1/from/lat: invalid value 1e999 (...)". Decoders of containers and
+// structs catch errors of nested values and rethrow them with the member name
+// / array index prepended.
+[[noreturn]] void rethrow_at(std::string_view member, std::exception const&);
+[[noreturn]] void rethrow_at(std::size_t index, std::exception const&);
+
+// json::value_to, numbers are checked to fit into T (int32, float, ...).
+template <class T>
+T read_value(json::value const& jv, json::string_view key) {
+  if constexpr (std::is_arithmetic_v<T> && !std::is_same_v<T, bool>) {
+    auto ec = boost::system::error_code{};
+    auto const x = jv.to_number<T>(ec);
+    if constexpr (std::is_floating_point_v<T>) {
+      if (!ec && std::isinf(x) && jv.is_double() &&
+          !std::isinf(jv.get_double())) {
+        ec = json::error::not_exact;
+      }
+    }
+    if (ec) {
+      [[unlikely]];
+      throw utl::fail("/{}: invalid value {} ({})", key,
+                      json::serialize(jv), ec.message());
+    }
+    return x;
+  } else {
+    return json::value_to<T>(jv);
+  }
+}
+
+// Decoding into an existing value: strings, vectors and maps keep their
+// capacity (maps are cleared, keeping their buckets), optionals are reused if
+// engaged. Generated types provide decode_into as hidden friend.
+template <class T>
+void decode_into(T&, json::value const&);
+inline void decode_into(std::string&, json::value const&);
+// The view would outlive the DOM, use openapi::document (document.h).
+void decode_into(std::string_view&, json::value const&) = delete;
+inline void decode_into(std::vector<double>&, json::value const&);
+template <class T>
+void decode_into(std::vector<T>&, json::value const&);
+template <class T>
+void decode_into(std::optional<T>&, json::value const&);
+template <class T>
+void decode_into(boost::unordered_flat_map<std::string, T>&,
+                 json::value const&);
+template <class T>
+void decode_into(ordered_map<T>&, json::value const&);
+
+// Bulk decoding of `type: array, items: {type: number}` members: converts
+// the parsed array in one pass, without per-element value_to dispatch.
+void read_numbers(json::array const&, std::vector<double>&);
+
+template <typename T>
+void read_map(json::object const& o,
+              boost::unordered_flat_map<std::string, T>& m) {
+  m.clear();
+  m.reserve(o.size());
+  for (auto const& [k, v] : o) {
+    try {
+      decode_into(m.try_emplace(std::string{k}).first->second, v);
+    } catch (std::exception const& e) {
+      rethrow_at(k, e);
+    }
+  }
+}
+
+// Array elements and map values: the caller prepends index / key.
+template <class T>
+void decode_into(T& t, json::value const& jv) {
+  t = read_value<T>(jv, "");
+}
+
+inline void decode_into(std::string& s, json::value const& jv) {
+  s.assign(jv.as_string());
+}
+
+inline void decode_into(std::vector<double>& v, json::value const& jv) {
+  read_numbers(jv.as_array(), v);
+}
+
+template <class T>
+void decode_into(std::vector<T>& v, json::value const& jv) {
+  auto const& arr = jv.as_array();
+  v.resize(arr.size());
+  auto i = std::size_t{0U};
+  try {
+    for (; i != arr.size(); ++i) {
+      if constexpr (std::is_same_v<T, bool>) {
+        v[i] = arr[i].as_bool();
+      } else {
+        decode_into(v[i], arr[i]);
+      }
+    }
+  } catch (std::exception const& e) {
+    rethrow_at(i, e);
+  }
+}
+
+template <class T>
+void decode_into(std::optional<T>& t, json::value const& jv) {
+  decode_into(t.has_value() ? *t : t.emplace(), jv);
+}
+
+template <class T>
+void decode_into(boost::unordered_flat_map<std::string, T>& m,
+                 json::value const& jv) {
+  read_map(jv.as_object(), m);
+}
+
+template <class T>
+void decode_into(ordered_map<T>& m, json::value const& jv) {
+  auto const& o = jv.as_object();
+  m.clear();
+  m.reserve(o.size());
+  for (auto const& [k, v] : o) {
+    try {
+      decode_into(m[k], v);
+    } catch (std::exception const& e) {
+      rethrow_at(k, e);
+    }
+  }
+}
+
 template <class T>
 void extract_member(json::object const& o, T& t, json::string_view key) {
   auto const it = o.find(key);
   if (it == o.end()) {
     [[unlikely]];
-    throw utl::fail("key {} not found in {}", key, json::serialize(o));
+    throw utl::fail("/: missing property {}", key);
+  }
+  if constexpr (std::is_arithmetic_v<T>) {
+    t = read_value<T>(it->value(), key);
+  } else {
+    try {
+      decode_into(t, it->value());
+    } catch (std::exception const& e) {
+      rethrow_at(key, e);
+    }
   }
-  t = json::value_to<T>(it->value());
 }
 
 template <class T>
@@ -28,8 +173,37 @@ void extract_member(json::object const& o,
                     std::optional<T>& t,
                     json::string_view key) {
   auto const it = o.find(key);
-  if (it != o.end()) {
-    t = json::value_to<T>(it->value());
+  if (it == o.end()) {
+    t.reset();
+  } else if constexpr (std::is_arithmetic_v<T>) {
+    t = read_value<T>(it->value(), key);
+  } else {
+    try {
+      decode_into(t, it->value());
+    } catch (std::exception const& e) {
+      rethrow_at(key, e);
+    }
+  }
+}
+
+template <class T>
+void extract_member(json::object const& o,
+                    compact_optional<T>& t,
+                    json::string_view key) {
+  auto const it = o.find(key);
+  if (it == o.end()) {
+    t.reset();
+  } else {
+    t = read_value<T>(it->value(), key);
+  }
+}
+
+template <class T>
+void write_member(json::object& o,
+                  compact_optional<T> const& t,
+                  json::string_view key) {
+  if (t.has_value()) {
+    o.emplace(key, json::value_from(*t));
   }
 }
 
@@ -47,6 +221,74 @@ void write_member(json::object& o, T const& t, json::string_view key) {
   o.emplace(key, json::value_from(t));
 }
 
+// additionalProperties next to properties: all members of `o` that are not
+// in `names` (the declared properties) go into the map.
+template <typename Map>
+void extract_additional(json::object const& o,
+                        Map& m,
+                        std::span<std::string_view const> names) {
+  m.clear();
+  for (auto const& [k, v] : o) {
+    auto const key = std::string_view{k};
+    if (std::ranges::find(names, key) != names.end()) {
+      continue;
+    }
+    try {
+      decode_into(m[std::string{key}], v);
+    } catch (std::exception const& e) {
+      rethrow_at(key, e);
+    }
+  }
+}
+
+// Declared members win over map entries with the same key.
+template <typename Map>
+void write_additional(json::object& o, Map const& m) {
+  for (auto const& [k, v] : m) {
+    o.emplace(k, json::value_from(v));
+  }
+}
+
+inline void extract_numbers(json::object const& o,
+                            std::vector<double>& v,
+                            json::string_view key) {
+  auto const it = o.find(key);
+  if (it == o.end()) {
+    [[unlikely]];
+    throw utl::fail("/: missing property {}", key);
+  }
+  try {
+    read_numbers(it->value().as_array(), v);
+  } catch (std::exception const& e) {
+    rethrow_at(key, e);
+  }
+}
+
+inline void extract_numbers(json::object const& o,
+                            std::optional<std::vector<double>>& v,
+                            json::string_view key) {
+  auto const it = o.find(key);
+  if (it == o.end()) {
+    v.reset();
+    return;
+  }
+  try {
+    read_numbers(it->value().as_array(), v.has_value() ? *v : v.emplace());
+  } catch (std::exception const& e) {
+    rethrow_at(key, e);
+  }
+}
+
+// Parses into a per-thread arena that is recycled by the next call, so
+// repeatedly parsing similar documents does not allocate after warm-up.
+// The result is valid until the next call on the same thread.
+json::value const& parse_temporary(std::string_view);
+
+template <class T>
+void parse_into(T& t, std::string_view s) {
+  decode_into(t, parse_temporary(s));
+}
+
 template <typename T>
 concept Enum = std::is_scoped_enum_v<T>;
 
@@ -0,0 +1,40 @@
+#pragma once
+
+#include <filesystem>
+#include <optional>
+#include <vector>
+
+#include "boost/json/fwd.hpp"
+
+#include "yaml-cpp/yaml.h"
+
+namespace openapi {
+
+// Loads an OpenAPI document: JSON for `.json` files, YAML otherwise.
+//
+// External references (`common.yml#/components/parameters/Limit`, or
+// `money.json` for a whole file) are resolved relative to the referring
+// file: the target is copied into the components section of the result
+// named by the pointer, otherwise into the section matching the position of
+// the reference (parameters, responses, ..., schemas by default). It is
+// named after the last pointer segment or the file stem and the reference
+// is rewritten to point there.
+//
+// With a cache directory, parsed files and the resolved document are
+// stored there as cista-serialized trees keyed by the content hash. A
+// resolved document is reused as long as none of the files it was built
+// from changed, so unchanged specs and shared component files are not
+// parsed again. The cached tree is still converted back into a YAML::Node
+// tree on every call. The directory may be shared by concurrent generator
+// runs.
+//
+// `dependencies` (if set) receives the absolute paths of all files the
+// document was built from, including the root file.
+YAML::Node load_spec(
+    std::filesystem::path const&,
+    std::optional<std::filesystem::path> const& cache_dir = std::nullopt,
+    std::vector<std::filesystem::path>* dependencies = nullptr);
+
+YAML::Node to_yaml(boost::json::value const&);
+
+}  // namespace openapi
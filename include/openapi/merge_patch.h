@@ -0,0 +1,268 @@
+#pragma once
+
+#include <optional>
+#include <string>
+#include <type_traits>
+
+#include "boost/json.hpp"
+#include "boost/unordered/unordered_flat_map.hpp"
+
+#include "utl/verify.h"
+
+#include "openapi/compact_optional.h"
+#include "openapi/json.h"
+#include "openapi/ordered_map.h"
+
+namespace openapi {
+
+// RFC 7386 JSON Merge Patch for generated types.
+//
+// diff(from, to) only contains what changed: members are compared with
+// operator== first, so unchanged subtrees cost one comparison and produce
+// nothing. Objects and maps are diffed recursively, removed optionals and
+// map entries become null. Arrays and variants are replaced as a whole
+// (a merge patch cannot address array elements).
+//
+// apply_patch(from, diff(from, to)) yields `to`. Generated types provide
+// diff_into / patch_into as hidden friends.
+
+// Free-form JSON (json::value members), RFC 7386 as specified.
+json::value diff(json::value const& from, json::value const& to);
+void apply_patch(json::value& target, json::value const& patch);
+
+template <typename T>
+concept diffable = requires(T const& c, json::object& patch) {
+  diff_into(patch, c, c);
+};
+
+// Types with borrowed (x-cpp-borrow) members are diffable only.
+template <typename T>
+concept merge_patchable =
+    diffable<T> && requires(T& t, json::object const& patch) {
+      patch_into(t, patch);
+    };
+
+// Patch value for `from` != `to`.
+template <typename T>
+json::value make_patch(T const& from, T const& to);
+template <typename T>
+json::value make_patch(std::optional<T> const&, std::optional<T> const&);
+template <typename T>
+json::value make_patch(boost::unordered_flat_map<std::string, T> const&,
+                       boost::unordered_flat_map<std::string, T> const&);
+template <typename T>
+json::value make_patch(ordered_map<T> const&, ordered_map<T> const&);
+inline json::value make_patch(json::value const&, json::value const&);
+
+template <typename T>
+void patch_member(T&, json::value const&, json::string_view key);
+template <typename T>
+void patch_member(std::optional<T>&, json::value const&, json::string_view);
+template <typename T>
+void patch_member(compact_optional<T>&,
+                  json::value const&,
+                  json::string_view key);
+template <typename T>
+void patch_member(boost::unordered_flat_map<std::string, T>&,
+                  json::value const&,
+                  json::string_view key);
+template <typename T>
+void patch_member(ordered_map<T>&, json::value const&, json::string_view key);
+inline void patch_member(json::value&, json::value const&, json::string_view);
+
+template <typename T>
+void diff_member(json::object& patch,
+                 T const& from,
+                 T const& to,
+                 json::string_view key) {
+  if (!(from == to)) {
+    patch[key] = make_patch(from, to);
+  }
+}
+
+template <typename T>
+void diff_member(json::object& patch,
+                 compact_optional<T> const& from,
+                 compact_optional<T> const& to,
+                 json::string_view key) {
+  if (!(from == to)) {
+    patch[key] = to.has_value() ? json::value_from(*to) : json::value{};
+  }
+}
+
+template <typename Map>
+void diff_map_into(json::object& patch, Map const& from, Map const& to) {
+  for (auto const& [k, v] : from) {
+    if (!to.contains(k)) {
+      patch[k] = nullptr;
+    }
+  }
+  for (auto const& [k, v] : to) {
+    auto const it = from.find(k);
+    if (it == from.end()) {
+      patch[k] = json::value_from(v);
+    } else if (!(it->second == v)) {
+      patch[k] = make_patch(it->second, v);
+    }
+  }
+}
+
+template <typename Map>
+json::value diff_map(Map const& from, Map const& to) {
+  auto patch = json::object{};
+  diff_map_into(patch, from, to);
+  return patch;
+}
+
+// additionalProperties: entries are members of the struct's own patch.
+template <typename Map>
+void diff_additional(json::object& patch, Map const& from, Map const& to) {
+  if (!(from == to)) {
+    diff_map_into(patch, from, to);
+  }
+}
+
+template <typename T>
+json::value make_patch(T const& from, T const& to) {
+  if constexpr (diffable<T>) {
+    auto patch = json::object{};
+    diff_into(patch, from, to);
+    return patch;
+  } else {
+    return json::value_from(to);
+  }
+}
+
+template <typename T>
+json::value make_patch(std::optional<T> const& from,
+                       std::optional<T> const& to) {
+  if (!to.has_value()) {
+    return nullptr;
+  } else if (!from.has_value()) {
+    return json::value_from(*to);
+  }
+  return make_patch(*from, *to);
+}
+
+template <typename T>
+json::value make_patch(boost::unordered_flat_map<std::string, T> const& from,
+                       boost::unordered_flat_map<std::string, T> const& to) {
+  return diff_map(from, to);
+}
+
+template <typename T>
+json::value make_patch(ordered_map<T> const& from, ordered_map<T> const& to) {
+  return diff_map(from, to);
+}
+
+inline json::value make_patch(json::value const& from, json::value const& to) {
+  return diff(from, to);
+}
+
+template <typename T>
+void patch_member(T& t, json::value const& patch, json::string_view key) {
+  if constexpr (merge_patchable<T>) {
+    if (patch.is_object()) {
+      patch_into(t, patch.get_object());
+      return;
+    }
+  }
+  if (patch.is_null()) {
+    [[unlikely]];
+    throw utl::fail("merge patch: {} is required", key);
+  }
+  if constexpr (std::is_arithmetic_v<T>) {
+    t = read_value<T>(patch, key);
+  } else {
+    decode_into(t, patch);
+  }
+}
+
+template <typename T>
+void patch_member(std::optional<T>& t,
+                  json::value const& patch,
+                  json::string_view key) {
+  if (patch.is_null()) {
+    t.reset();
+  } else {
+    patch_member(t.has_value() ? *t : t.emplace(), patch, key);
+  }
+}
+
+template <typename T>
+void patch_member(compact_optional<T>& t,
+                  json::value const& patch,
+                  json::string_view key) {
+  if (patch.is_null()) {
+    t.reset();
+  } else {
+    t = read_value<T>(patch, key);
+  }
+}
+
+template <typename T>
+void patch_member(boost::unordered_flat_map<std::string, T>& m,
+                  json::value const& patch,
+                  json::string_view key) {
+  utl::verify(patch.is_object(), "merge patch: {} expects an object", key);
+  for (auto const& [k, v] : patch.get_object()) {
+    if (v.is_null()) {
+      m.erase(std::string{k});
+    } else {
+      patch_member(m.try_emplace(std::string{k}).first->second, v, k);
+    }
+  }
+}
+
+// New entries are appended, existing entries keep their position.
+template <typename T>
+void patch_member(ordered_map<T>& m,
+                  json::value const& patch,
+                  json::string_view key) {
+  utl::verify(patch.is_object(), "merge patch: {} expects an object", key);
+  for (auto const& [k, v] : patch.get_object()) {
+    if (v.is_null()) {
+      m.erase(k);
+    } else {
+      patch_member(m[k], v, k);
+    }
+  }
+}
+
+inline void patch_member(json::value& t,
+                         json::value const& patch,
+                         json::string_view) {
+  apply_patch(t, patch);
+}
+
+// Patch member that is not a declared property: null removes the entry.
+template <typename Map>
+void patch_additional(Map& m, json::string_view key, json::value const& patch) {
+  if (patch.is_null()) {
+    m.erase(std::string{key});
+  } else {
+    patch_member(m[std::string{key}], patch, key);
+  }
+}
+
+// Patch for an object type is `{}` if nothing changed. Other types have no
+// "unchanged" patch, the full value is returned.
+template <typename T>
+json::value diff(T const& from, T const& to) {
+  if constexpr (diffable<T>) {
+    auto patch = json::object{};
+    if (!(from == to)) {
+      diff_into(patch, from, to);
+    }
+    return patch;
+  } else {
+    return from == to ? json::value_from(to) : make_patch(from, to);
+  }
+}
+
+template <typename T>
+void apply_patch(T& t, json::value const& patch) {
+  patch_member(t, patch, "/");
+}
+
+}  // namespace openapi
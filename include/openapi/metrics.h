@@ -0,0 +1,106 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <exception>
+#include <iosfwd>
+#include <string>
+#include <string_view>
+
+namespace openapi::metrics {
+
+enum class stage : std::uint8_t { kParams, kDecode, kEncode };
+
+constexpr auto const kStages = 3U;
+
+// Log-linear (HDR style) latency buckets in nanoseconds: 4 sub-buckets per
+// power of two, values >= 2^41ns (~37min) end up in the last bucket.
+constexpr auto const kSubBucketBits = 2U;
+constexpr auto const kSubBuckets = 1U << kSubBucketBits;
+constexpr auto const kMaxMsb = 40U;
+constexpr auto const kBuckets = kMaxMsb * kSubBuckets;
+
+std::size_t bucket(std::uint64_t ns);
+
+// Exclusive upper bound of the bucket in nanoseconds.
+std::uint64_t bucket_limit(std::size_t);
+
+struct alignas(64) shard {
+  std::array<std::atomic<std::uint64_t>, kBuckets> buckets_{};
+  std::atomic<std::uint64_t> count_{0U};
+  std::atomic<std::uint64_t> sum_ns_{0U};
+  std::atomic<std::uint64_t> bytes_{0U};
+  std::atomic<std::uint64_t> errors_{0U};
+};
+
+// Counters for one operationId. Threads are assigned to one of kShards
+// shards round robin (more than kShards threads share shards), writes are
+// relaxed atomics, exporters sum the shards up.
+struct operation {
+  static constexpr auto const kShards = 8U;
+
+  explicit operation(std::string_view id);
+
+  void record(stage,
+              std::chrono::nanoseconds,
+              std::size_t bytes,
+              bool error) noexcept;
+
+  std::uint64_t count(stage) const;
+  std::uint64_t bytes(stage) const;
+  std::uint64_t errors(stage) const;
+
+  std::string id_;
+  std::array<std::array<shard, kStages>, kShards> shards_;
+};
+
+operation& get(std::string_view operation_id);
+
+void write_prometheus(std::ostream&);
+
+struct scope {
+  scope(operation& op, stage const s)
+      : op_{op},
+        stage_{s},
+        uncaught_{std::uncaught_exceptions()},
+        start_{std::chrono::steady_clock::now()} {}
+
+  scope(scope const&) = delete;
+  scope(scope&&) = delete;
+  scope& operator=(scope const&) = delete;
+  scope& operator=(scope&&) = delete;
+
+  ~scope() {
+    op_.record(stage_, std::chrono::steady_clock::now() - start_, bytes_,
+               std::uncaught_exceptions() > uncaught_);
+  }
+
+  void bytes(std::size_t const n) { bytes_ = n; }
+
+  operation& op_;
+  stage stage_;
+  int uncaught_;
+  std::size_t bytes_{0U};
+  std::chrono::steady_clock::time_point start_;
+};
+
+}  // namespace openapi::metrics
+
+// Used by generated code, expands to nothing unless OPENAPI_METRICS is set.
+//
+// Recorded: parse_<op>_params (stage kParams), decode_<op>_body (kDecode)
+// and the encode_<op>_response overloads (kEncode). Constructing *_params
+// directly from params_view is not recorded: the parsing happens in member
+// initializers, before a scope in the constructor body could start.
+#ifdef OPENAPI_METRICS
+#define OPENAPI_METRICS_SCOPE(operation_id, s)                               \
+  static auto& openapi_metrics_op = ::openapi::metrics::get(operation_id); \
+  auto openapi_metrics_scope =                                             \
+      ::openapi::metrics::scope{openapi_metrics_op, ::openapi::metrics::s}
+#define OPENAPI_METRICS_BYTES(n) openapi_metrics_scope.bytes(n)
+#else
+#define OPENAPI_METRICS_SCOPE(operation_id, s)
+#define OPENAPI_METRICS_BYTES(n)
+#endif
@@ -0,0 +1,466 @@
+#pragma once
+
+#include <chrono>
+#include <cmath>
+#include <concepts>
+#include <cstdint>
+#include <limits>
+#include <optional>
+#include <span>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "boost/json/value.hpp"
+#include "boost/unordered/unordered_flat_map.hpp"
+
+#include "utl/verify.h"
+
+#include "openapi/compact_optional.h"
+#include "openapi/date_time.h"
+#include "openapi/enum_set.h"
+#include "openapi/intern.h"
+#include "openapi/ordered_map.h"
+
+namespace openapi {
+
+// MessagePack codecs for generated types, meant for internal RPC between
+// services generated from the same spec. Objects are maps keyed by property
+// name or, with msgpack_keys::kIndices, by the property index in spec order
+// (enums likewise by name or index). Readers accept both forms.
+// Variants are written as [alternative index, value].
+enum class msgpack_keys : std::uint8_t { kNames, kIndices };
+
+// Timestamp extension type (-1): seconds since the epoch + nanoseconds.
+struct msgpack_timestamp {
+  std::int64_t seconds_;
+  std::uint32_t nanoseconds_;
+};
+
+struct msgpack_writer {
+  explicit msgpack_writer(std::string& out,
+                          msgpack_keys const keys = msgpack_keys::kNames)
+      : out_{out}, keys_{keys} {}
+
+  void write_nil();
+  void write_bool(bool);
+  void write_int(std::int64_t);
+  void write_uint(std::uint64_t);
+  void write_float(float);
+  void write_double(double);
+  void write_string(std::string_view);
+  void write_timestamp(msgpack_timestamp);
+  void write_array(std::size_t size);
+  void write_map(std::size_t size);
+
+  // Property name or index, depending on keys_.
+  void write_key(std::uint32_t index, std::string_view name);
+
+  std::string& out_;
+  msgpack_keys keys_;
+};
+
+struct msgpack_reader {
+  explicit msgpack_reader(std::string_view in) : in_{in} {}
+
+  bool is_nil() const;
+  bool is_string() const;
+  bool at_end() const { return pos_ == in_.size(); }
+
+  void read_nil();
+  bool read_bool();
+  std::int64_t read_int();
+  std::uint64_t read_uint();
+  double read_double();
+  std::string_view read_string();  // points into the input
+  msgpack_timestamp read_timestamp();
+  // Element counts are checked against the remaining input (every element
+  // takes at least one byte), callers may reserve / resize with them.
+  std::uint32_t read_array();
+  std::uint32_t read_map();
+
+  // Index of the key in `names` (an integer key is taken as index),
+  // names.size() for unknown keys. Unknown string keys are kept in
+  // unknown_key_ (additionalProperties), unknown indices reset it.
+  std::uint32_t read_key(std::span<std::string_view const> names);
+
+  void skip();
+
+  std::string_view in_;
+  std::size_t pos_{0U};
+  std::optional<std::string_view> unknown_key_;
+};
+
+// Types without generated codec. Generated structs, variants and enums
+// provide msgpack_write / msgpack_read themselves (found by ADL).
+template <std::integral T>
+void msgpack_write(msgpack_writer&, T);
+template <std::floating_point T>
+void msgpack_write(msgpack_writer&, T);
+inline void msgpack_write(msgpack_writer&, std::string const&);
+inline void msgpack_write(msgpack_writer&, std::string_view);
+inline void msgpack_write(msgpack_writer&, interned_string const&);
+inline void msgpack_write(msgpack_writer&, date_time_t);
+void msgpack_write(msgpack_writer&, boost::json::value const&);
+template <typename T>
+void msgpack_write(msgpack_writer&, std::vector<T> const&);
+template <typename T>
+void msgpack_write(msgpack_writer&, std::optional<T> const&);
+template <typename T>
+void msgpack_write(msgpack_writer&, compact_optional<T> const&);
+template <typename T>
+void msgpack_write(msgpack_writer&,
+                   boost::unordered_flat_map<std::string, T> const&);
+template <typename T>
+void msgpack_write(msgpack_writer&, ordered_map<T> const&);
+template <typename E, std::size_t N>
+void msgpack_write(msgpack_writer&, enum_set<E, N> const&);
+
+template <std::integral T>
+void msgpack_read(msgpack_reader&, T&);
+template <std::floating_point T>
+void msgpack_read(msgpack_reader&, T&);
+inline void msgpack_read(msgpack_reader&, std::string&);
+// The view would outlive the input buffer.
+void msgpack_read(msgpack_reader&, std::string_view&) = delete;
+inline void msgpack_read(msgpack_reader&, interned_string&);
+inline void msgpack_read(msgpack_reader&, date_time_t&);
+void msgpack_read(msgpack_reader&, boost::json::value&);
+template <typename T>
+void msgpack_read(msgpack_reader&, std::vector<T>&);
+template <typename T>
+void msgpack_read(msgpack_reader&, std::optional<T>&);
+template <typename T>
+void msgpack_read(msgpack_reader&, compact_optional<T>&);
+template <typename T>
+void msgpack_read(msgpack_reader&, boost::unordered_flat_map<std::string, T>&);
+template <typename T>
+void msgpack_read(msgpack_reader&, ordered_map<T>&);
+template <typename E, std::size_t N>
+void msgpack_read(msgpack_reader&, enum_set<E, N>&);
+
+template <std::integral T>
+void msgpack_write(msgpack_writer& w, T const x) {
+  if constexpr (std::is_same_v<T, bool>) {
+    w.write_bool(x);
+  } else if constexpr (std::is_signed_v<T>) {
+    w.write_int(x);
+  } else {
+    w.write_uint(x);
+  }
+}
+
+template <std::floating_point T>
+void msgpack_write(msgpack_writer& w, T const x) {
+  if constexpr (std::is_same_v<T, float>) {
+    w.write_float(x);
+  } else {
+    w.write_double(static_cast<double>(x));
+  }
+}
+
+inline void msgpack_write(msgpack_writer& w, std::string const& s) {
+  w.write_string(s);
+}
+
+inline void msgpack_write(msgpack_writer& w, std::string_view const s) {
+  w.write_string(s);
+}
+
+inline void msgpack_write(msgpack_writer& w, interned_string const& s) {
+  w.write_string(s.view());
+}
+
+// [timestamp, UTC offset in minutes], not the packed in-memory bits.
+inline void msgpack_write(msgpack_writer& w, date_time_t const t) {
+  auto const s = std::chrono::floor<std::chrono::seconds>(t.time());
+  auto const ns = std::chrono::nanoseconds{t.time() - s};
+  w.write_array(2U);
+  w.write_timestamp({s.time_since_epoch().count(),
+                     static_cast<std::uint32_t>(ns.count())});
+  w.write_int(t.offset().count());
+}
+
+template <typename T>
+void msgpack_write(msgpack_writer& w, std::vector<T> const& v) {
+  w.write_array(v.size());
+  for (auto const& x : v) {
+    msgpack_write(w, x);
+  }
+}
+
+template <typename T>
+void msgpack_write(msgpack_writer& w, std::optional<T> const& t) {
+  if (t.has_value()) {
+    msgpack_write(w, *t);
+  } else {
+    w.write_nil();
+  }
+}
+
+template <typename T>
+void msgpack_write(msgpack_writer& w, compact_optional<T> const& t) {
+  if (t.has_value()) {
+    msgpack_write(w, *t);
+  } else {
+    w.write_nil();
+  }
+}
+
+template <typename T>
+void msgpack_write(msgpack_writer& w,
+                   boost::unordered_flat_map<std::string, T> const& m) {
+  w.write_map(m.size());
+  for (auto const& [k, v] : m) {
+    w.write_string(k);
+    msgpack_write(w, v);
+  }
+}
+
+template <typename T>
+void msgpack_write(msgpack_writer& w, ordered_map<T> const& m) {
+  w.write_map(m.size());
+  for (auto const& [k, v] : m) {
+    w.write_string(k);
+    msgpack_write(w, v);
+  }
+}
+
+template <typename E, std::size_t N>
+void msgpack_write(msgpack_writer& w, enum_set<E, N> const& s) {
+  w.write_array(s.size());
+  for (auto const e : s) {
+    msgpack_write(w, e);
+  }
+}
+
+template <std::integral T>
+void msgpack_read(msgpack_reader& r, T& x) {
+  if constexpr (std::is_same_v<T, bool>) {
+    x = r.read_bool();
+  } else if constexpr (std::is_signed_v<T>) {
+    auto const i = r.read_int();
+    utl::verify(std::in_range<T>(i), "msgpack: {} out of range", i);
+    x = static_cast<T>(i);
+  } else {
+    auto const i = r.read_uint();
+    utl::verify(std::in_range<T>(i), "msgpack: {} out of range", i);
+    x = static_cast<T>(i);
+  }
+}
+
+template <std::floating_point T>
+void msgpack_read(msgpack_reader& r, T& x) {
+  auto const d = r.read_double();
+  x = static_cast<T>(d);
+  utl::verify(std::isinf(x) == std::isinf(d), "msgpack: {} out of range", d);
+}
+
+inline void msgpack_read(msgpack_reader& r, std::string& s) {
+  s.assign(r.read_string());
+}
+
+inline void msgpack_read(msgpack_reader& r, interned_string& s) {
+  s = interned_string{r.read_string()};
+}
+
+// Time and offset are range checked, date_time_t throws if the time is not
+// representable.
+inline void msgpack_read(msgpack_reader& r, date_time_t& t) {
+  utl::verify(r.read_array() == 2U, "msgpack: expected [timestamp, offset]");
+  auto const [seconds, nanoseconds] = r.read_timestamp();
+  auto const offset = r.read_int();
+  constexpr auto const kMaxSeconds =
+      std::numeric_limits<std::int64_t>::max() / 1000;
+  utl::verify(seconds > -kMaxSeconds && seconds < kMaxSeconds,
+              "msgpack: timestamp {}s out of range", seconds);
+  utl::verify(offset > -date_time_t::kOffsetBias &&
+                  offset < date_time_t::kOffsetBias,
+              "msgpack: offset {}min out of range", offset);
+  using ms = std::chrono::milliseconds;
+  t = date_time_t{std::chrono::sys_time<ms>{ms{seconds * 1000 +
+                                               nanoseconds / 1'000'000U}},
+                  std::chrono::minutes{offset}};
+}
+
+template <typename T>
+void msgpack_read(msgpack_reader& r, std::vector<T>& v) {
+  v.resize(r.read_array());
+  for (auto i = std::size_t{0U}; i != v.size(); ++i) {
+    if constexpr (std::is_same_v<T, bool>) {
+      v[i] = r.read_bool();
+    } else {
+      msgpack_read(r, v[i]);
+    }
+  }
+}
+
+template <typename T>
+void msgpack_read(msgpack_reader& r, std::optional<T>& t) {
+  if (r.is_nil()) {
+    r.read_nil();
+    t.reset();
+  } else {
+    msgpack_read(r, t.has_value() ? *t : t.emplace());
+  }
+}
+
+template <typename T>
+void msgpack_read(msgpack_reader& r, compact_optional<T>& t) {
+  if (r.is_nil()) {
+    r.read_nil();
+    t.reset();
+  } else {
+    auto x = T{};
+    msgpack_read(r, x);
+    t = x;
+  }
+}
+
+template <typename T>
+void msgpack_read(msgpack_reader& r,
+                  boost::unordered_flat_map<std::string, T>& m) {
+  auto const n = r.read_map();
+  m.clear();
+  m.reserve(n);
+  for (auto i = 0U; i != n; ++i) {
+    msgpack_read(r, m.try_emplace(std::string{r.read_string()}).first->second);
+  }
+}
+
+template <typename T>
+void msgpack_read(msgpack_reader& r, ordered_map<T>& m) {
+  auto const n = r.read_map();
+  m.clear();
+  m.reserve(n);
+  for (auto i = 0U; i != n; ++i) {
+    msgpack_read(r, m[r.read_string()]);
+  }
+}
+
+template <typename E, std::size_t N>
+void msgpack_read(msgpack_reader& r, enum_set<E, N>& s) {
+  s.clear();
+  for (auto n = r.read_array(); n != 0U; --n) {
+    auto e = E{};
+    msgpack_read(r, e);
+    s.insert(e);
+  }
+}
+
+// Entry points for generated code. Unqualified calls, so the hidden friends
+// of generated types are found.
+template <typename T>
+void msgpack_write_value(msgpack_writer& w, T const& t) {
+  msgpack_write(w, t);
+}
+
+template <typename T>
+void msgpack_read_value(msgpack_reader& r, T& t) {
+  msgpack_read(r, t);
+}
+
+// Absent optionals are omitted, like in JSON.
+template <typename T>
+bool msgpack_present(T const&) {
+  return true;
+}
+
+template <typename T>
+bool msgpack_present(std::optional<T> const& t) {
+  return t.has_value();
+}
+
+template <typename T>
+bool msgpack_present(compact_optional<T> const& t) {
+  return t.has_value();
+}
+
+template <typename T>
+void msgpack_write_member(msgpack_writer& w,
+                          std::uint32_t const index,
+                          std::string_view name,
+                          T const& t) {
+  if (msgpack_present(t)) {
+    w.write_key(index, name);
+    msgpack_write(w, t);
+  }
+}
+
+// additionalProperties: keyed by name also with msgpack_keys::kIndices.
+template <typename Map>
+void msgpack_write_additional(msgpack_writer& w, Map const& m) {
+  for (auto const& [k, v] : m) {
+    w.write_string(k);
+    msgpack_write(w, v);
+  }
+}
+
+// Value of the unknown key just read, an unknown index is skipped.
+template <typename Map>
+void msgpack_read_additional(msgpack_reader& r, Map& m) {
+  if (!r.unknown_key_.has_value()) {
+    r.skip();
+    return;
+  }
+  msgpack_read(r, m[std::string{*r.unknown_key_}]);
+}
+
+// Member not contained in the map: optionals are reset, everything else is
+// required (same as extract_member).
+template <typename T>
+void msgpack_missing(T&, std::string_view type, std::string_view name) {
+  throw utl::fail("msgpack: {}.{} missing", type, name);
+}
+
+template <typename T>
+void msgpack_missing(std::optional<T>& t, std::string_view, std::string_view) {
+  t.reset();
+}
+
+template <typename T>
+void msgpack_missing(compact_optional<T>& t,
+                     std::string_view,
+                     std::string_view) {
+  t.reset();
+}
+
+template <typename T>
+std::string to_msgpack(T const& t,
+                       msgpack_keys const keys = msgpack_keys::kNames) {
+  auto out = std::string{};
+  auto w = msgpack_writer{out, keys};
+  msgpack_write(w, t);
+  return out;
+}
+
+// Decodes into an existing value, reusing its capacity like decode_into.
+template <typename T>
+void msgpack_into(T& t, std::string_view s) {
+  auto r = msgpack_reader{s};
+  msgpack_read(r, t);
+  utl::verify(r.at_end(), "msgpack: {} trailing bytes", s.size() - r.pos_);
+}
+
+template <typename T>
+T from_msgpack(std::string_view s) {
+  auto t = T{};
+  msgpack_into(t, s);
+  return t;
+}
+
+// Content negotiation between JSON (default) and MessagePack.
+enum class wire_format : std::uint8_t { kJson, kMsgpack };
+
+// Format for an Accept header: the one with the higher q-value, ties go to
+// the format named explicitly (not only matched by a wildcard), then JSON.
+wire_format negotiate(std::string_view accept);
+
+// Format of a Content-Type header, nullopt for other media types.
+std::optional<wire_format> from_content_type(std::string_view);
+
+std::string_view content_type(wire_format);
+
+}  // namespace openapi
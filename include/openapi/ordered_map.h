@@ -0,0 +1,185 @@
+#pragma once
+
+#include <functional>
+#include <initializer_list>
+#include <string>
+#include <string_view>
+#include <tuple>
+#include <utility>
+#include <vector>
+
+#include "boost/json/value.hpp"
+#include "boost/json/value_from.hpp"
+#include "boost/json/value_to.hpp"
+#include "boost/unordered/unordered_flat_map.hpp"
+
+#include "utl/verify.h"
+
+namespace openapi {
+
+// String keyed map that keeps insertion order (for byte-stable output).
+// Entries are stored contiguously, the flat hash index refers to the keys
+// stored in the entries and is rebuilt whenever the entry storage moves.
+template <typename T>
+struct ordered_map {
+  using key_type = std::string;
+  using mapped_type = T;
+  using value_type = std::pair<std::string, T>;
+  using iterator = typename std::vector<value_type>::iterator;
+  using const_iterator = typename std::vector<value_type>::const_iterator;
+
+  ordered_map() = default;
+
+  ordered_map(std::initializer_list<value_type> init) {
+    reserve(init.size());
+    for (auto const& [k, v] : init) {
+      emplace(k, v);
+    }
+  }
+
+  ordered_map(ordered_map const& o) : entries_{o.entries_} { rebuild_index(); }
+
+  ordered_map& operator=(ordered_map const& o) {
+    if (this != &o) {
+      entries_ = o.entries_;
+      rebuild_index();
+    }
+    return *this;
+  }
+
+  // Moving the vector keeps its buffer, so the index stays valid.
+  ordered_map(ordered_map&&) noexcept = default;
+  ordered_map& operator=(ordered_map&&) noexcept = default;
+
+  ~ordered_map() = default;
+
+  void reserve(std::size_t const n) {
+    if (n > entries_.capacity()) {
+      entries_.reserve(n);
+      rebuild_index();
+    }
+    index_.reserve(n);
+  }
+
+  void clear() {
+    entries_.clear();
+    index_.clear();
+  }
+
+  template <typename... Args>
+  std::pair<iterator, bool> emplace(std::string_view key, Args&&... args) {
+    if (auto const it = index_.find(key); it != index_.end()) {
+      return {begin() + static_cast<std::ptrdiff_t>(it->second), false};
+    }
+    auto const grow = entries_.size() == entries_.capacity();
+    entries_.emplace_back(std::piecewise_construct, std::forward_as_tuple(key),
+                          std::forward_as_tuple(std::forward<Args>(args)...));
+    if (grow) {
+      rebuild_index();
+    } else {
+      index_.emplace(entries_.back().first, entries_.size() - 1U);
+    }
+    return {std::prev(end()), true};
+  }
+
+  T& operator[](std::string_view key) { return emplace(key).first->second; }
+
+  T& at(std::string_view key) {
+    auto const it = find(key);
+    utl::verify(it != end(), "ordered_map: key {} not found", key);
+    return it->second;
+  }
+
+  T const& at(std::string_view key) const {
+    auto const it = find(key);
+    utl::verify(it != end(), "ordered_map: key {} not found", key);
+    return it->second;
+  }
+
+  iterator find(std::string_view key) {
+    auto const it = index_.find(key);
+    return it == index_.end()
+               ? end()
+               : begin() + static_cast<std::ptrdiff_t>(it->second);
+  }
+
+  const_iterator find(std::string_view key) const {
+    auto const it = index_.find(key);
+    return it == index_.end()
+               ? end()
+               : begin() + static_cast<std::ptrdiff_t>(it->second);
+  }
+
+  bool contains(std::string_view key) const { return index_.contains(key); }
+
+  // Keeps the order of the remaining entries (linear).
+  std::size_t erase(std::string_view key) {
+    auto const it = index_.find(key);
+    if (it == index_.end()) {
+      return 0U;
+    }
+    entries_.erase(entries_.begin() + static_cast<std::ptrdiff_t>(it->second));
+    rebuild_index();
+    return 1U;
+  }
+
+  std::size_t size() const { return entries_.size(); }
+  bool empty() const { return entries_.empty(); }
+
+  iterator begin() { return entries_.begin(); }
+  iterator end() { return entries_.end(); }
+  const_iterator begin() const { return entries_.begin(); }
+  const_iterator end() const { return entries_.end(); }
+
+  // Same semantics as the unordered maps: order does not matter for equality.
+  friend bool operator==(ordered_map const& a, ordered_map const& b) {
+    if (a.size() != b.size()) {
+      return false;
+    }
+    for (auto const& [k, v] : a) {
+      auto const it = b.find(k);
+      if (it == b.end() || !(it->second == v)) {
+        return false;
+      }
+    }
+    return true;
+  }
+
+  friend void tag_invoke(boost::json::value_from_tag,
+                         boost::json::value& jv,
+                         ordered_map const& m) {
+    auto& o = (jv = boost::json::object{}).as_object();
+    o.reserve(m.size());
+    for (auto const& [k, v] : m) {
+      o.emplace(k, boost::json::value_from(v));
+    }
+  }
+
+  friend ordered_map tag_invoke(boost::json::value_to_tag<ordered_map>,
+                                boost::json::value const& jv) {
+    auto m = ordered_map{};
+    auto const& o = jv.as_object();
+    m.reserve(o.size());
+    for (auto const& [k, v] : o) {
+      m.emplace(k, boost::json::value_to<T>(v));
+    }
+    return m;
+  }
+
+private:
+  void rebuild_index() {
+    index_.clear();
+    index_.reserve(entries_.size());
+    for (auto i = std::size_t{0U}; i != entries_.size(); ++i) {
+      index_.emplace(entries_[i].first, i);
+    }
+  }
+
+  std::vector<value_type> entries_;
+  boost::unordered_flat_map<std::string_view,
+                            std::size_t,
+                            std::hash<std::string_view>>
+      index_;
+};
+
+}  // namespace openapi
@@ -0,0 +1,145 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "boost/json/serializer.hpp"
+#include "boost/json/value.hpp"
+#include "boost/json/value_from.hpp"
+
+namespace openapi {
+
+// Fixed set of worker threads for splitting one large encoding job into
+// chunks. Workers (and the calling thread) claim chunk indices from a shared
+// counter, so a slow chunk does not hold up the others.
+// One job at a time: run() while another job is in progress (on another
+// thread or from within fn) calls fn on the calling thread instead of
+// waiting for the pool.
+struct encode_pool {
+  // n_threads includes the calling thread, 1 = no workers.
+  explicit encode_pool(
+      unsigned n_threads = std::thread::hardware_concurrency());
+  ~encode_pool();
+
+  encode_pool(encode_pool const&) = delete;
+  encode_pool& operator=(encode_pool const&) = delete;
+
+  // Calls fn(i) for every i in [0, n), returns when all calls are done.
+  // Rethrows the first exception thrown by fn.
+  void run(std::size_t n, std::function<void(std::size_t)> const& fn);
+
+  unsigned size() const {
+    return static_cast<unsigned>(workers_.size()) + 1U;
+  }
+
+private:
+  void worker();
+  void work(std::function<void(std::size_t)> const&, std::size_t n);
+
+  std::atomic_bool busy_{false};
+
+  std::mutex mutex_;
+  std::condition_variable start_, done_;
+  std::size_t generation_{0U};
+  bool stop_{false};
+
+  std::function<void(std::size_t)> const* fn_{nullptr};
+  std::size_t n_{0U};
+  std::atomic_size_t next_{0U};
+  std::size_t active_{0U};  // threads working on the current job
+  std::exception_ptr error_;
+
+  std::vector<std::thread> workers_;
+};
+
+// Shared pool with one thread per core.
+encode_pool& default_encode_pool();
+
+struct parallel_encode_options {
+  // Arrays shorter than this are encoded on the calling thread.
+  std::size_t threshold_{4096U};
+  std::size_t chunk_size_{1024U};
+};
+
+// Serialized JSON array in pieces: concatenated they form the array text
+// (e.g. for a scatter-gather write). Encoded in parallel above the threshold.
+template <typename T>
+std::vector<std::string> encode_array_chunks(
+    std::vector<T> const& v,
+    encode_pool& pool = default_encode_pool(),
+    parallel_encode_options const& opt = {}) {
+  auto const encode_range = [&](std::size_t const from, std::size_t const to,
+                                std::string& out) {
+    auto jv = boost::json::value{};
+    auto sr = boost::json::serializer{};
+    char buf[4096];
+    for (auto i = from; i != to; ++i) {
+      if (i != 0U) {
+        out.push_back(',');
+      }
+      boost::json::value_from(v[i], jv);
+      sr.reset(&jv);
+      while (!sr.done()) {
+        out.append(sr.read(buf));
+      }
+    }
+  };
+
+  auto const chunk_size = std::max(opt.chunk_size_, std::size_t{1U});
+  auto chunks = std::vector<std::string>{};
+  if (v.size() < opt.threshold_ || v.size() <= chunk_size ||
+      pool.size() == 1U) {
+    auto& out = chunks.emplace_back("[");
+    encode_range(0U, v.size(), out);
+    out.push_back(']');
+    return chunks;
+  }
+
+  chunks.resize((v.size() + chunk_size - 1U) / chunk_size);
+  pool.run(chunks.size(), [&](std::size_t const i) {
+    auto& out = chunks[i];
+    if (i == 0U) {
+      out.push_back('[');
+    }
+    encode_range(i * chunk_size, std::min(v.size(), (i + 1U) * chunk_size),
+                 out);
+    if (i == chunks.size() - 1U) {
+      out.push_back(']');
+    }
+  });
+  return chunks;
+}
+
+inline std::size_t total_size(std::vector<std::string> const& chunks) {
+  auto size = std::size_t{0U};
+  for (auto const& c : chunks) {
+    size += c.size();
+  }
+  return size;
+}
+
+template <typename T>
+std::string encode_array(std::vector<T> const& v,
+                         encode_pool& pool = default_encode_pool(),
+                         parallel_encode_options const& opt = {}) {
+  auto chunks = encode_array_chunks(v, pool, opt);
+  if (chunks.size() == 1U) {
+    return std::move(chunks.front());
+  }
+  auto out = std::string{};
+  out.reserve(total_size(chunks));
+  for (auto const& c : chunks) {
+    out.append(c);
+  }
+  return out;
+}
+
+}  // namespace openapi
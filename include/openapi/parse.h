@@ -2,8 +2,12 @@
 
 #include "boost/url/params_view.hpp"
 
+#include <charconv>
+#include <cmath>
 #include <sstream>
 #include <string_view>
+#include <system_error>
+#include <utility>
 #include <vector>
 
 #include "utl/parser/arg_parser.h"
@@ -34,6 +38,32 @@ void parse(std::string_view s, T& v) {
   utl::parse_arg(cs, v);
 }
 
+// Integer / number formats narrower than std::int64_t / double.
+template <typename T>
+  requires(std::is_arithmetic_v<T> && !Primitive<T>)
+void parse(std::string_view s, T& v) {
+  if constexpr (std::is_floating_point_v<T>) {
+    auto x = double{};
+    parse(s, x);
+    v = static_cast<T>(x);
+    utl::verify(std::isfinite(v) || !std::isfinite(x),
+                "parameter value {} out of range", s);
+  } else if constexpr (std::is_unsigned_v<T>) {
+    // Not via std::int64_t: std::uint64_t values above INT64_MAX are valid.
+    auto x = std::uint64_t{};
+    auto const end = s.data() + s.size();
+    auto const [ptr, ec] = std::from_chars(s.data(), end, x);
+    utl::verify(ec == std::errc{} && ptr == end && std::in_range<T>(x),
+                "parameter value {} out of range", s);
+    v = static_cast<T>(x);
+  } else {
+    auto x = std::int64_t{};
+    parse(s, x);
+    utl::verify(std::in_range<T>(x), "parameter value {} out of range", s);
+    v = static_cast<T>(x);
+  }
+}
+
 template <typename T>
 void parse(std::string_view s, std::vector<T>& v) {
   utl::for_each_token(
@@ -47,6 +77,16 @@ void parse(std::string_view s, std::optional<T>& v) {
   v = x;
 }
 
+// Empty state for *_params::reset(), strings and vectors keep their capacity.
+template <typename T>
+void clear_param(T& x) {
+  if constexpr (requires { x.clear(); }) {
+    x.clear();
+  } else {
+    x = T{};
+  }
+}
+
 template <typename T>
 T parse_param(boost::urls::params_view const& params,
               std::string_view name,
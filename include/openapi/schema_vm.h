@@ -0,0 +1,110 @@
+#pragma once
+
+#include <cstdint>
+#include <limits>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "yaml-cpp/yaml.h"
+
+namespace openapi {
+
+// Runtime counterpart of the generated codecs for specs that are only
+// known at runtime: a schema is compiled into a flat program (same type
+// mapping as to_type / get_type: number formats, enums, allOf, maps,
+// oneOf / anyOf with discriminator) that is executed by a small VM on the
+// JSON parser events, without building a json::value.
+//
+// Variants are the exception: their subtree is buffered and replayed per
+// alternative (or only for the one selected by the discriminator).
+
+enum class opcode : std::uint8_t {
+  kAny,  // free-form value, no type
+  kBoolean,
+  kInteger,
+  kNumber,
+  kString,
+  kDate,
+  kEnum,
+  kArray,
+  kObject,
+  kMap,
+  kVariant
+};
+
+enum class number_format : std::uint8_t {
+  kInt8,
+  kInt16,
+  kInt32,
+  kInt64,
+  kUInt8,
+  kUInt16,
+  kUInt32,
+  kUInt64,
+  kFloat,
+  kDouble
+};
+
+constexpr auto const kNoTarget = std::numeric_limits<std::uint32_t>::max();
+
+// kEnum: strings_[begin_, end_) sorted, kObject: properties_[begin_, end_)
+// sorted by name, kArray / kMap: target_ = items / values (or kNoTarget),
+// kVariant: target_ = index into variants_.
+struct instruction {
+  opcode op_{opcode::kAny};
+  number_format format_{number_format::kInt64};
+  std::uint32_t begin_{0U}, end_{0U};
+  std::uint32_t target_{kNoTarget};
+};
+
+struct schema_property {
+  std::uint32_t name_;  // index into strings_
+  std::uint32_t pc_;
+  std::uint8_t required_bit_;  // kOptional if not required
+  static constexpr auto const kOptional = std::uint8_t{0xFFU};
+};
+
+// Discriminator value -> alternative.
+struct variant_tag {
+  std::uint32_t value_;  // index into strings_
+  std::uint32_t pc_;
+};
+
+struct variant_info {
+  std::uint32_t discriminator_{kNoTarget};  // index into strings_
+  std::uint32_t alternatives_begin_{0U}, alternatives_end_{0U};
+  std::uint32_t tags_begin_{0U}, tags_end_{0U};
+};
+
+struct schema_program {
+  std::vector<instruction> code_;
+  std::vector<std::string> strings_;
+  std::vector<schema_property> properties_;
+  std::vector<std::uint32_t> alternatives_;
+  std::vector<variant_tag> tags_;
+  std::vector<variant_info> variants_;
+  std::uint32_t entry_{0U};
+};
+
+// `root` is the OpenAPI document, `schema` one of its schemas (may be a
+// $ref). Each referenced component is compiled once, recursion is allowed.
+schema_program compile_schema(YAML::Node const& root, YAML::Node const& schema);
+
+// Shorthand for #/components/schemas/<name>.
+schema_program compile_schema(YAML::Node const& root, std::string_view name);
+
+// Error message with JSON pointer if the document does not match.
+std::optional<std::string> validate(schema_program const&, std::string_view);
+
+// Copy of the document without properties unknown to the schema.
+// Throws if the document does not match.
+std::string filter(schema_program const&, std::string_view);
+
+// Like filter, additionally writes values in their canonical form:
+// integer schemas as integers (3.0 -> 3), `format: float` rounded to float
+// precision, date-times as written by to_str.
+std::string normalize(schema_program const&, std::string_view);
+
+}  // namespace openapi
@@ -0,0 +1,157 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <exception>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <tuple>
+#include <utility>
+#include <vector>
+
+#include "boost/unordered/unordered_flat_map.hpp"
+
+#include "cista/hash.h"
+
+#include "openapi/etag.h"
+
+namespace openapi {
+
+// Generated *_params types expose their members via cista_members().
+template <typename T>
+concept has_members = requires(T const& t) { t.cista_members(); };
+
+template <has_members T>
+cista::hash_t members_hash(T const& t) {
+  auto h = content_hash{};
+  std::apply([&](auto const&... m) { (hash_value(h, m), ...); },
+             t.cista_members());
+  return h.h_;
+}
+
+template <has_members T>
+bool members_equal(T const& a, T const& b) {
+  return a.cista_members() == b.cista_members();
+}
+
+struct single_flight_stats {
+  std::atomic<std::uint64_t> calls_{0U};
+  std::atomic<std::uint64_t> coalesced_{0U};  // answered by another call
+  std::atomic<std::uint64_t> timeouts_{0U};  // gave up waiting, computed
+};
+
+// Request coalescing for one operation: concurrent calls with equal params
+// run the computation once and share its serialized result. A call that
+// arrives after the computation finished starts a new one (no caching).
+//
+// Waiting callers give up after `timeout` and compute the response
+// themselves. Exceptions of the computation are rethrown to all waiting
+// callers. The in-flight table is split into shards (by params hash), each
+// with its own mutex held only for lookup / insert / erase.
+template <has_members Params>
+struct single_flight {
+  using result_t = std::shared_ptr<std::string const>;
+
+  static constexpr auto const kShards = 16U;
+
+  explicit single_flight(
+      std::chrono::milliseconds const timeout = std::chrono::seconds{30})
+      : timeout_{timeout} {}
+
+  single_flight(single_flight const&) = delete;
+  single_flight& operator=(single_flight const&) = delete;
+
+  // compute: () -> std::string (the encoded response)
+  template <typename Fn>
+  result_t run(Params const& params, Fn&& compute) {
+    auto const hash = members_hash(params);
+    auto& s = shards_[hash % kShards];
+    auto promise = std::optional<std::promise<result_t>>{};
+    auto result = std::shared_future<result_t>{};
+    {
+      auto const lock = std::lock_guard{s.mutex_};
+      auto& flights = s.in_flight_[hash];
+      for (auto const& f : flights) {
+        if (members_equal(f.params_, params)) {
+          result = f.result_;
+          break;
+        }
+      }
+      if (!result.valid()) {
+        result = promise.emplace().get_future().share();
+        flights.push_back({params, result});
+      }
+    }
+    stats_.calls_.fetch_add(1U, std::memory_order_relaxed);
+
+    if (!promise.has_value()) {
+      if (result.wait_for(timeout_) == std::future_status::ready) {
+        stats_.coalesced_.fetch_add(1U, std::memory_order_relaxed);
+        return result.get();
+      }
+      stats_.timeouts_.fetch_add(1U, std::memory_order_relaxed);
+      return std::make_shared<std::string const>(compute());
+    }
+
+    try {
+      auto r = std::make_shared<std::string const>(compute());
+      erase(s, hash, params);
+      promise->set_value(r);
+      return r;
+    } catch (...) {
+      erase(s, hash, params);
+      promise->set_exception(std::current_exception());
+      throw;
+    }
+  }
+
+  std::size_t in_flight() const {
+    auto n = std::size_t{0U};
+    for (auto& s : shards_) {
+      auto const lock = std::lock_guard{s.mutex_};
+      for (auto const& [hash, flights] : s.in_flight_) {
+        n += flights.size();
+      }
+    }
+    return n;
+  }
+
+  single_flight_stats const& stats() const { return stats_; }
+
+private:
+  struct flight {
+    Params params_;
+    std::shared_future<result_t> result_;
+  };
+
+  struct alignas(64) shard {
+    mutable std::mutex mutex_;
+    boost::unordered_flat_map<cista::hash_t, std::vector<flight>> in_flight_;
+  };
+
+  static void erase(shard& s, cista::hash_t const hash, Params const& params) {
+    auto const lock = std::lock_guard{s.mutex_};
+    auto const it = s.in_flight_.find(hash);
+    if (it == s.in_flight_.end()) {
+      return;
+    }
+    auto& flights = it->second;
+    std::erase_if(flights, [&](flight const& f) {
+      return members_equal(f.params_, params);
+    });
+    if (flights.empty()) {
+      s.in_flight_.erase(it);
+    }
+  }
+
+  std::chrono::milliseconds timeout_;
+  std::array<shard, kShards> shards_;
+  single_flight_stats stats_;
+};
+
+}  // namespace openapi
@@ -0,0 +1,226 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <memory>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <vector>
+
+#include "boost/json/serializer.hpp"
+#include "boost/json/value.hpp"
+#include "boost/json/value_from.hpp"
+#include "boost/unordered/unordered_flat_map.hpp"
+
+#include "openapi/compact_optional.h"
+#include "openapi/ordered_map.h"
+
+namespace openapi {
+
+// Destination for streamed encoder output.
+struct sink {
+  sink() = default;
+  sink(sink const&) = delete;
+  sink& operator=(sink const&) = delete;
+  virtual ~sink() = default;
+
+  virtual void write(std::string_view) = 0;
+
+  // End of output: flushes everything buffered. No writes afterwards.
+  virtual void finish() {}
+};
+
+struct string_sink final : sink {
+  explicit string_sink(std::string& out) : out_{out} {}
+  void write(std::string_view s) override { out_.append(s); }
+
+  std::string& out_;
+};
+
+enum class compression { kGzip, kDeflate };
+
+// Compresses blocks of block_size bytes as they fill and forwards the
+// compressed output to `next` (also in pieces of at most block_size bytes).
+// kDeflate produces the zlib format (HTTP "Content-Encoding: deflate").
+struct zlib_sink final : sink {
+  // level: zlib compression level, -1 = zlib default
+  explicit zlib_sink(sink& next,
+                     compression = compression::kGzip,
+                     int level = -1,
+                     std::size_t block_size = 64U * 1024U);
+  ~zlib_sink() override;
+
+  void write(std::string_view) override;
+  void finish() override;
+
+private:
+  struct impl;
+
+  void deflate_block(bool last);
+
+  sink& next_;
+  std::unique_ptr<impl> impl_;
+  std::string in_, out_;
+  std::size_t block_size_;
+  bool finished_{false};
+};
+
+// Buffered JSON text output into a sink. Containers and generated structs
+// are written element by element / member by member (write_json below), so
+// encoding never holds more than one leaf value as boost::json::value.
+struct json_writer {
+  explicit json_writer(sink& s) : sink_{s} {}
+
+  void write(std::string_view);  // JSON text as is
+  void value(boost::json::value const&);
+  void key(std::string_view);  // "key":
+  void separator(bool& first);  // "," before all but the first element
+
+  // Passes buffered output to the sink, returns the total number of bytes.
+  std::size_t flush();
+
+private:
+  void drain();
+
+  sink& sink_;
+  boost::json::serializer sr_;
+  std::array<char, 4096U> buf_;
+  std::size_t used_{0U}, size_{0U};
+};
+
+// Types without generated write_json (hidden friend of generated structs)
+// go through boost::json::value_from.
+template <typename T>
+void write_json(json_writer&, T const&);
+inline void write_json(json_writer&, boost::json::value const&);
+template <typename T>
+void write_json(json_writer&, std::vector<T> const&);
+template <typename T>
+void write_json(json_writer&, std::optional<T> const&);
+template <typename T>
+void write_json(json_writer&, compact_optional<T> const&);
+template <typename T>
+void write_json(json_writer&,
+                boost::unordered_flat_map<std::string, T> const&);
+template <typename T>
+void write_json(json_writer&, ordered_map<T> const&);
+
+template <typename T>
+void write_json(json_writer& w, T const& t) {
+  w.value(boost::json::value_from(t));
+}
+
+inline void write_json(json_writer& w, boost::json::value const& jv) {
+  w.value(jv);
+}
+
+template <typename T>
+void write_json(json_writer& w, std::vector<T> const& v) {
+  w.write("[");
+  auto first = true;
+  for (auto const& x : v) {
+    w.separator(first);
+    if constexpr (std::is_same_v<T, bool>) {
+      w.write(x ? "true" : "false");
+    } else {
+      write_json(w, x);
+    }
+  }
+  w.write("]");
+}
+
+template <typename T>
+void write_json(json_writer& w, std::optional<T> const& t) {
+  if (t.has_value()) {
+    write_json(w, *t);
+  } else {
+    w.write("null");
+  }
+}
+
+template <typename T>
+void write_json(json_writer& w, compact_optional<T> const& t) {
+  if (t.has_value()) {
+    write_json(w, *t);
+  } else {
+    w.write("null");
+  }
+}
+
+template <typename Map>
+void write_json_object(json_writer& w, Map const& m) {
+  w.write("{");
+  auto first = true;
+  for (auto const& [k, v] : m) {
+    w.separator(first);
+    w.key(k);
+    write_json(w, v);
+  }
+  w.write("}");
+}
+
+template <typename T>
+void write_json(json_writer& w,
+                boost::unordered_flat_map<std::string, T> const& m) {
+  write_json_object(w, m);
+}
+
+template <typename T>
+void write_json(json_writer& w, ordered_map<T> const& m) {
+  write_json_object(w, m);
+}
+
+// Called by generated write_json, mirrors write_member (json.h): empty
+// optionals are omitted.
+template <typename T>
+void write_json_member(json_writer& w,
+                       bool& first,
+                       T const& t,
+                       std::string_view const key) {
+  w.separator(first);
+  w.key(key);
+  write_json(w, t);
+}
+
+template <typename T>
+void write_json_member(json_writer& w,
+                       bool& first,
+                       std::optional<T> const& t,
+                       std::string_view const key) {
+  if (t.has_value()) {
+    write_json_member(w, first, *t, key);
+  }
+}
+
+template <typename T>
+void write_json_member(json_writer& w,
+                       bool& first,
+                       compact_optional<T> const& t,
+                       std::string_view const key) {
+  if (t.has_value()) {
+    write_json_member(w, first, *t, key);
+  }
+}
+
+// additionalProperties of generated structs, after the declared members.
+template <typename Map>
+void write_json_additional(json_writer& w, bool& first, Map const& m) {
+  for (auto const& [k, v] : m) {
+    write_json_member(w, first, v, k);
+  }
+}
+
+// Streams the serialized JSON into the sink, returns the number of bytes.
+// Does not call finish().
+std::size_t serialize(boost::json::value const&, sink&);
+
+template <typename T>
+std::size_t encode(T const& t, sink& s) {
+  auto w = json_writer{s};
+  write_json(w, t);
+  return w.flush();
+}
+
+}  // namespace openapi
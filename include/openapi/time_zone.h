@@ -0,0 +1,37 @@
+#pragma once
+
+#include <chrono>
+#include <string>
+#include <string_view>
+
+#include "openapi/date_time.h"
+
+namespace date {
+class time_zone;
+}  // namespace date
+
+namespace openapi {
+
+// IANA time zone for rendering timestamps in local time.
+// Zone lookups by name are cached process wide. Each thread caches the
+// last transition ranges (begin, end, offset), so consecutive conversions
+// in the same zone and range need no transition search.
+// Thread safe; offsets are rounded down to whole minutes.
+struct time_zone {
+  explicit time_zone(std::string_view name);
+
+  std::chrono::minutes offset(
+      std::chrono::sys_time<std::chrono::milliseconds>) const;
+
+  // Same instant, offset of this zone.
+  date_time_t to_local(date_time_t) const;
+
+  date::time_zone const* tz_;
+};
+
+// ISO 8601 in the local time of the zone with +-hh:mm offset, `Z` when the
+// offset is zero (UTC, Europe/London in winter), same as to_str(date_time_t).
+std::string to_str(date_time_t, time_zone const&);
+std::string to_str(date_time_t, std::string_view zone);
+
+}  // namespace openapi
@@ -1,7 +1,10 @@
 #include "openapi/date_time.h"
 
+#include <cstdlib>
 #include <ostream>
 
+#include "fmt/format.h"
+
 #include "utl/verify.h"
 
 #include "date/date.h"
@@ -9,14 +12,51 @@
 
 namespace openapi {
 
+std::int64_t offset_time::pack(
+    std::chrono::sys_time<std::chrono::milliseconds> const t,
+    std::chrono::minutes const offset) {
+  constexpr auto const kMaxMs = std::int64_t{1} << (63U - kOffsetBits);
+  auto const ms = t.time_since_epoch().count();
+  utl::verify(ms >= -kMaxMs && ms < kMaxMs, "date_time: {}ms out of range",
+              ms);
+  utl::verify(std::abs(offset.count()) < kOffsetBias,
+              "date_time: offset {}min out of range", offset.count());
+  return static_cast<std::int64_t>(static_cast<std::uint64_t>(ms)
+                                   << kOffsetBits) |
+         (offset.count() + kOffsetBias);
+}
+
+std::string to_str(date_time_t const t) {
+  auto const local = t.time() + t.offset();
+  auto const day = std::chrono::floor<date::days>(local);
+  auto const ymd = date::year_month_day{day};
+  auto const hms = date::hh_mm_ss<std::chrono::milliseconds>{local - day};
+
+  auto s = fmt::format("{:04}-{:02}-{:02}T{:02}:{:02}:{:02}",
+                       static_cast<int>(ymd.year()),
+                       static_cast<unsigned>(ymd.month()),
+                       static_cast<unsigned>(ymd.day()), hms.hours().count(),
+                       hms.minutes().count(), hms.seconds().count());
+  if (hms.subseconds().count() != 0) {
+    s += fmt::format(".{:03}", hms.subseconds().count());
+  }
+
+  auto const offset = t.offset().count();
+  if (offset == 0) {
+    s += 'Z';
+  } else {
+    s += fmt::format("{}{:02}:{:02}", offset < 0 ? '-' : '+',
+                     std::abs(offset) / 60, std::abs(offset) % 60);
+  }
+  return s;
+}
+
 std::ostream& operator<<(std::ostream& out, date_time_t const& t) {
-  utl::verify(t.offset_ == std::chrono::minutes{0}, "offset not supported yet");
-  out << date::format("%FT%TZ", t.time_);
-  return out;
+  return out << to_str(t);
 }
 
 date_time_t now() {
-  return std::chrono::time_point_cast<std::chrono::seconds>(
+  return std::chrono::floor<std::chrono::milliseconds>(
       std::chrono::system_clock::now());
 }
 
@@ -0,0 +1,289 @@
+#include "openapi/document.h"
+
+#include <cstring>
+#include <functional>
+
+#include "boost/json/basic_parser_impl.hpp"
+
+#include "utl/verify.h"
+
+namespace openapi {
+
+namespace {
+
+struct token_handler {
+  constexpr static auto const max_object_size = std::size_t(-1);
+  constexpr static auto const max_array_size = std::size_t(-1);
+  constexpr static auto const max_key_size = std::size_t(-1);
+  constexpr static auto const max_string_size = std::size_t(-1);
+
+  token_handler(std::string_view const in, json::monotonic_resource& arena)
+      : in_{in}, arena_{arena} {}
+
+  bool on_document_begin(json::error_code&) { return true; }
+  bool on_document_end(json::error_code&) { return true; }
+
+  bool on_object_begin(json::error_code&) { return begin(json::kind::object); }
+  bool on_object_end(std::size_t const n, json::error_code&) { return end(n); }
+  bool on_array_begin(json::error_code&) { return begin(json::kind::array); }
+  bool on_array_end(std::size_t const n, json::error_code&) { return end(n); }
+
+  bool on_key_part(json::string_view s, std::size_t, json::error_code&) {
+    buf_.append(s.data(), s.size());
+    return true;
+  }
+  bool on_key(json::string_view s, std::size_t, json::error_code&) {
+    return push(
+        {.kind_ = json::kind::string, .key_ = true, .str_ = complete(s)});
+  }
+  bool on_string_part(json::string_view s, std::size_t, json::error_code&) {
+    buf_.append(s.data(), s.size());
+    return true;
+  }
+  bool on_string(json::string_view s, std::size_t, json::error_code&) {
+    return push({.kind_ = json::kind::string, .str_ = complete(s)});
+  }
+
+  bool on_number_part(json::string_view, json::error_code&) { return true; }
+  bool on_int64(std::int64_t const i, json::string_view, json::error_code&) {
+    if (i >= -kMaxExact && i <= kMaxExact) {
+      return number(static_cast<double>(i), true);
+    }
+    return push({.kind_ = json::kind::int64, .i_ = i});
+  }
+  bool on_uint64(std::uint64_t const u, json::string_view, json::error_code&) {
+    return push({.kind_ = json::kind::uint64, .u_ = u});
+  }
+  bool on_double(double const d, json::string_view, json::error_code&) {
+    return number(d, false);
+  }
+  bool on_bool(bool const b, json::error_code&) {
+    return push({.kind_ = json::kind::bool_, .b_ = b});
+  }
+  bool on_null(json::error_code&) { return push({}); }
+
+  bool on_comment_part(json::string_view, json::error_code&) { return true; }
+  bool on_comment(json::string_view, json::error_code&) { return true; }
+
+  // The parser passes unescaped strings as view into the input. Escaped
+  // strings arrive in parts from its temporary buffer.
+  std::string_view complete(json::string_view const s) {
+    auto const in_input =
+        std::less_equal<>{}(in_.data(), s.data()) &&
+        std::less_equal<>{}(s.data() + s.size(), in_.data() + in_.size());
+    if (buf_.empty() && in_input) {
+      return {s.data(), s.size()};
+    }
+    buf_.append(s.data(), s.size());
+    auto const copy = static_cast<char*>(arena_.allocate(buf_.size(), 1U));
+    std::memcpy(copy, buf_.data(), buf_.size());
+    auto const str = std::string_view{copy, buf_.size()};
+    buf_.clear();
+    return str;
+  }
+
+  bool begin(json::kind const k) {
+    spill();
+    open_.push_back({.token_ = out_.tokens_.size(),
+                     .first_ = out_.numbers_.size(),
+                     .numbers_ = k == json::kind::array});
+    out_.tokens_.push_back({.kind_ = k});
+    return true;
+  }
+
+  bool end(std::size_t const n) {
+    auto const& o = open_.back();
+    auto& t = out_.tokens_[o.token_];
+    t.size_ = n;
+    t.end_ = out_.tokens_.size();
+    t.numbers_ = o.numbers_;
+    t.first_ = o.first_;
+    open_.pop_back();
+    return true;
+  }
+
+  bool number(double const d, bool const integer) {
+    if (open_.empty() || !open_.back().numbers_) {
+      return push(integer ? json_token{.kind_ = json::kind::int64,
+                                       .i_ = static_cast<std::int64_t>(d)}
+                          : json_token{.kind_ = json::kind::double_, .d_ = d});
+    }
+    out_.numbers_.push_back(d);
+    out_.integers_.push_back(integer);
+    return true;
+  }
+
+  bool push(json_token const& t) {
+    spill();
+    out_.tokens_.push_back(t);
+    return true;
+  }
+
+  // The innermost array was a number array so far, but gets another value:
+  // its numbers become tokens.
+  void spill() {
+    if (open_.empty() || !open_.back().numbers_) {
+      return;
+    }
+    auto& o = open_.back();
+    for (auto i = o.first_; i != out_.numbers_.size(); ++i) {
+      auto const d = out_.numbers_[i];
+      out_.tokens_.push_back(
+          out_.integers_[i]
+              ? json_token{.kind_ = json::kind::int64,
+                           .i_ = static_cast<std::int64_t>(d)}
+              : json_token{.kind_ = json::kind::double_, .d_ = d});
+    }
+    out_.numbers_.resize(o.first_);
+    out_.integers_.resize(o.first_);
+    o.numbers_ = false;
+  }
+
+  struct container {
+    std::size_t token_;
+    std::size_t first_;
+    bool numbers_;
+  };
+
+  // Larger integers are not exact as double, they end a number array.
+  static constexpr auto const kMaxExact = std::int64_t{1} << 53U;
+
+  std::string_view in_;
+  json::monotonic_resource& arena_;
+  std::string buf_;
+  std::vector<container> open_;
+  json_tokens out_;
+};
+
+json_token const& expect(json_token_reader const& r, json::kind const k) {
+  if (r.numbers_left_ != 0U) {
+    [[unlikely]];
+    throw utl::fail("/: expected {}, got number",
+                    std::string_view{to_string(k)});
+  }
+  auto const& t = r.in_.tokens_[r.pos_];
+  if (t.kind_ != k || t.key_) {
+    [[unlikely]];
+    throw utl::fail("/: expected {}, got {}", std::string_view{to_string(k)},
+                    t.key_ ? "key" : std::string_view{to_string(t.kind_)});
+  }
+  return t;
+}
+
+}  // namespace
+
+json_tokens parse_tokens(std::string_view const in,
+                         json::monotonic_resource& arena) {
+  auto parser =
+      json::basic_parser<token_handler>{json::parse_options{}, in, arena};
+  auto ec = json::error_code{};
+  auto const n = parser.write_some(false, in.data(), in.size(), ec);
+  if (!ec && n != in.size()) {
+    ec = json::error::extra_data;
+  }
+  utl::verify(!ec, "invalid JSON: {}", ec.message());
+  return std::move(parser.handler().out_);
+}
+
+void parse_numbers(std::string_view const s, std::vector<double>& v) {
+  read_json_into(v, s);
+}
+
+std::string_view json_token_reader::read_string() {
+  auto const str = expect(*this, json::kind::string).str_;
+  ++pos_;
+  return str;
+}
+
+std::size_t json_token_reader::read_object() {
+  auto const size = expect(*this, json::kind::object).size_;
+  ++pos_;
+  return size;
+}
+
+std::size_t json_token_reader::read_array() {
+  auto const& t = expect(*this, json::kind::array);
+  ++pos_;
+  if (t.numbers_) {
+    number_ = t.first_;
+    numbers_left_ = t.size_;
+  }
+  return t.size_;
+}
+
+void json_token_reader::read_numbers(std::vector<double>& v) {
+  auto const& t = in_.tokens_[pos_];
+  if (numbers_left_ == 0U && t.numbers_) {
+    auto const first = in_.numbers_.data() + t.first_;
+    v.assign(first, first + t.size_);
+    ++pos_;
+  } else {
+    openapi::read_numbers(read_value().as_array(), v);
+  }
+}
+
+std::uint32_t json_token_reader::read_key(
+    std::span<std::string_view const> names) {
+  auto const key = in_.tokens_[pos_++].str_;
+  for (auto i = 0U; i != names.size(); ++i) {
+    if (names[i] == key) {
+      return i;
+    }
+  }
+  unknown_key_ = key;
+  return static_cast<std::uint32_t>(names.size());
+}
+
+json::value json_token_reader::read_value() {
+  if (numbers_left_ != 0U) {
+    --numbers_left_;
+    auto const d = in_.numbers_[number_];
+    return in_.integers_[number_++]
+               ? json::value(static_cast<std::int64_t>(d), storage_)
+               : json::value(d, storage_);
+  }
+  auto const& t = in_.tokens_[pos_++];
+  switch (t.kind_) {
+    case json::kind::null: return json::value(nullptr, storage_);
+    case json::kind::bool_: return json::value(t.b_, storage_);
+    case json::kind::int64: return json::value(t.i_, storage_);
+    case json::kind::uint64: return json::value(t.u_, storage_);
+    case json::kind::double_: return json::value(t.d_, storage_);
+    case json::kind::string: return json::value(t.str_, storage_);
+    case json::kind::array: {
+      auto a = json::array(storage_);
+      a.reserve(t.size_);
+      if (t.numbers_) {
+        number_ = t.first_;
+        numbers_left_ = t.size_;
+      }
+      for (auto i = std::size_t{0U}; i != t.size_; ++i) {
+        a.push_back(read_value());
+      }
+      return a;
+    }
+    case json::kind::object: {
+      auto o = json::object(t.size_, storage_);
+      for (auto i = std::size_t{0U}; i != t.size_; ++i) {
+        auto const key = in_.tokens_[pos_++].str_;
+        o.insert_or_assign(key, read_value());
+      }
+      return o;
+    }
+  }
+  std::unreachable();
+}
+
+void json_token_reader::skip() {
+  if (numbers_left_ != 0U) {
+    --numbers_left_;
+    ++number_;
+    return;
+  }
+  auto const& t = in_.tokens_[pos_];
+  pos_ = t.kind_ == json::kind::array || t.kind_ == json::kind::object
+             ? t.end_
+             : pos_ + 1U;
+}
+
+}  // namespace openapi
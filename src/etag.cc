@@ -0,0 +1,85 @@
+#include "openapi/etag.h"
+
+#include "boost/json.hpp"
+
+#include "fmt/format.h"
+
+namespace openapi {
+
+void hash_value(content_hash& h, boost::json::value const& v) {
+  // 1 may be stored as int64 or uint64, both serialize the same.
+  auto const kind = v.is_int64() && v.get_int64() >= 0
+                        ? boost::json::kind::uint64
+                        : v.kind();
+  h.update(static_cast<std::uint64_t>(kind));
+  switch (v.kind()) {
+    case boost::json::kind::null: return;
+    case boost::json::kind::bool_:
+      h.update(std::uint64_t{v.get_bool()});
+      return;
+    case boost::json::kind::int64: hash_value(h, v.get_int64()); return;
+    case boost::json::kind::uint64: hash_value(h, v.get_uint64()); return;
+    case boost::json::kind::double_: hash_value(h, v.get_double()); return;
+    case boost::json::kind::string:
+      h.update(std::string_view{v.get_string()});
+      return;
+    case boost::json::kind::array:
+      h.update(static_cast<std::uint64_t>(v.get_array().size()));
+      for (auto const& x : v.get_array()) {
+        hash_value(h, x);
+      }
+      return;
+    case boost::json::kind::object: {
+      // Like unordered_flat_map: {"a":1,"b":2} == {"b":2,"a":1}.
+      auto sum = std::uint64_t{0U};
+      for (auto const& [k, x] : v.get_object()) {
+        auto entry = content_hash{};
+        entry.update(std::string_view{k});
+        hash_value(entry, x);
+        sum += entry.h_;
+      }
+      h.update(static_cast<std::uint64_t>(v.get_object().size()));
+      h.update(sum);
+      return;
+    }
+  }
+}
+
+std::string etag(cista::hash_t const h) {
+  return fmt::format("W/\"{:016x}\"", h);
+}
+
+bool etag_matches(std::string_view if_none_match, std::string_view const etag) {
+  auto const trim = [](std::string_view s) {
+    while (!s.empty() && (s.front() == ' ' || s.front() == '\t')) {
+      s.remove_prefix(1U);
+    }
+    while (!s.empty() && (s.back() == ' ' || s.back() == '\t')) {
+      s.remove_suffix(1U);
+    }
+    return s;
+  };
+
+  // Weak comparison (RFC 9110 13.1.2): W/ prefixes are ignored.
+  auto const opaque = [](std::string_view s) {
+    return s.starts_with("W/") ? s.substr(2U) : s;
+  };
+
+  if (trim(if_none_match) == "*") {
+    return true;
+  }
+  while (!if_none_match.empty()) {
+    auto const comma = if_none_match.find(',');
+    auto const tag = trim(if_none_match.substr(0U, comma));
+    if (!tag.empty() && opaque(tag) == opaque(etag)) {
+      return true;
+    }
+    if (comma == std::string_view::npos) {
+      break;
+    }
+    if_none_match.remove_prefix(comma + 1U);
+  }
+  return false;
+}
+
+}  // namespace openapi
@@ -1,7 +1,13 @@
 #include "openapi/gen_types.h"
 
+#include <algorithm>
+#include <functional>
+#include <limits>
+#include <numeric>
 #include <optional>
 #include <ostream>
+#include <utility>
+#include <vector>
 
 #include "utl/enumerate.h"
 
@@ -17,15 +23,30 @@ void write_prelude(std::string_view path_to_header,
 #include <string_view>
 #include <map>
 #include <string>
+#include <variant>
 
 #include "boost/url.hpp"
 #include "boost/json/fwd.hpp"
+#include "boost/json/value.hpp"
+#include "boost/unordered/unordered_flat_map.hpp"
 
+#include "openapi/compact_optional.h"
 #include "openapi/date_time.h"
+#include "openapi/document.h"
+#include "openapi/enum_set.h"
+#include "openapi/etag.h"
+#include "openapi/intern.h"
+#include "openapi/msgpack.h"
+#include "openapi/ordered_map.h"
+#include "openapi/parallel_encode.h"
+#include "openapi/sink.h"
 )";
 
   source << R"(#include ")" << path_to_header << "\"\n";
   source << R"(
+#include <array>
+#include <bitset>
+
 #include "cista/hash.h"
 
 #include "boost/json.hpp"
@@ -33,6 +54,8 @@ void write_prelude(std::string_view path_to_header,
 #include "utl/verify.h"
 
 #include "openapi/json.h"
+#include "openapi/merge_patch.h"
+#include "openapi/metrics.h"
 #include "openapi/parse.h"
 
 namespace std {
@@ -69,7 +92,23 @@ void write_postlude(std::ostream& header,
   }
 }
 
+YAML::Node get_alternatives(YAML::Node const& schema) {
+  auto const one_of = schema["oneOf"];
+  return one_of.IsDefined() ? one_of : schema["anyOf"];
+}
+
+bool has_type(YAML::Node const& schema) {
+  return schema["type"].IsDefined() || schema["allOf"].IsDefined() ||
+         get_alternatives(schema).IsDefined();
+}
+
 type to_type(YAML::Node const& schema) {
+  if (get_alternatives(schema).IsDefined()) {
+    return type::kVariant;
+  } else if (schema["allOf"].IsDefined()) {
+    return type::kObject;
+  }
+
   auto const s = schema["type"].as<std::string_view>();
   auto const format_node = schema["format"];
   auto const format =
@@ -101,11 +140,79 @@ std::string_view to_cpp(type const t) {
     case type::kString: return "std::string";
     case type::kBoolean: return "bool";
     case type::kArray: return "std::vector";
-    case type::kObject: return "std::map<std::string, std::uint64_t>";
+    case type::kObject: return "boost::unordered_flat_map";
+    case type::kVariant: return "std::variant";
     default: std::unreachable();
   }
 }
 
+// C++ type of an integer / number schema: x-cpp-type, format or default.
+std::string_view get_number_type(YAML::Node const& schema) {
+  auto const t = to_type(schema);
+  auto const cpp_type = schema["x-cpp-type"];
+  if (cpp_type.IsDefined()) {
+    auto const x = cpp_type.as<std::string_view>();
+    switch (cista::hash(x)) {
+      case cista::hash("std::int8_t"):
+      case cista::hash("std::int16_t"):
+      case cista::hash("std::int32_t"):
+      case cista::hash("std::int64_t"):
+      case cista::hash("std::uint8_t"):
+      case cista::hash("std::uint16_t"):
+      case cista::hash("std::uint32_t"):
+      case cista::hash("std::uint64_t"):
+        if (t == type::kInteger) {
+          return x;
+        }
+        break;
+      case cista::hash("float"):
+      case cista::hash("double"):
+        if (t == type::kNumber) {
+          return x;
+        }
+        break;
+    }
+    throw utl::fail("x-cpp-type {} not supported for {}", x,
+                    schema["type"].as<std::string_view>());
+  }
+
+  auto const format_node = schema["format"];
+  auto const format =
+      format_node.IsDefined() ? format_node.as<std::string_view>() : "";
+  if (t == type::kNumber) {
+    return format == "float" ? "float" : "double";
+  }
+  switch (cista::hash(format)) {
+    case cista::hash("int8"): return "std::int8_t";
+    case cista::hash("int16"): return "std::int16_t";
+    case cista::hash("int32"): return "std::int32_t";
+    case cista::hash("uint8"): return "std::uint8_t";
+    case cista::hash("uint16"): return "std::uint16_t";
+    case cista::hash("uint32"): return "std::uint32_t";
+    case cista::hash("uint64"): return "std::uint64_t";
+    default: return to_cpp(type::kInteger);
+  }
+}
+
+std::size_t get_number_size(std::string_view const cpp_type) {
+  switch (cista::hash(cpp_type)) {
+    case cista::hash("std::int8_t"):
+    case cista::hash("std::uint8_t"): return 1U;
+    case cista::hash("std::int16_t"):
+    case cista::hash("std::uint16_t"): return 2U;
+    case cista::hash("std::int32_t"):
+    case cista::hash("std::uint32_t"):
+    case cista::hash("float"): return 4U;
+    default: return 8U;
+  }
+}
+
+// Enums with up to 255 values (the maximum is reserved for
+// compact_optional) use std::uint8_t as underlying type.
+bool is_small_enum(YAML::Node const& enumera) {
+  return enumera.size() <= 255U;
+}
+
 struct indent {
   explicit indent(int indent, char separator = ',')
       : indent_{indent}, separator_{separator} {}
@@ -141,7 +248,8 @@ bool gen_enum(std::string_view type_name,
   auto const enumera = schema["enum"];
   if (enumera.IsDefined()) {
     {
-      header << "enum class " << name << " {";
+      header << "enum class " << name
+             << (is_small_enum(enumera) ? " : std::uint8_t" : "") << " {";
       auto ind = indent{1};
       for (auto const& e : enumera) {
         ind(header);
@@ -150,14 +258,15 @@ bool gen_enum(std::string_view type_name,
       header << "\n};\n\n";
     }
 
+    if (enumera.size() <= 64U) {
+      header << "using " << name << "Set = openapi::enum_set<" << name << ", "
+             << enumera.size() << ">;\n\n";
+    }
+
     {
-      header << name << " tag_invoke(boost::json::value_to_tag<" << name
-             << ">, boost::json::value const&);\n";
+      header << "void parse(std::string_view, " << name << "&);\n";
 
-      source << name << " tag_invoke(boost::json::value_to_tag<" << name
-             << ">, boost::json::value const& jv) {\n";
-      source << "  auto x = " << name << "{};\n";
-      source << "  auto const sv = std::string_view{jv.as_string()};\n";
+      source << "void parse(std::string_view sv, " << name << "& x) {\n";
       source << "  switch (cista::hash(sv)) {";
       auto ind = indent{2, 0};
       for (auto const& e : enumera) {
@@ -169,6 +278,17 @@ bool gen_enum(std::string_view type_name,
       source << "default: throw utl::fail(\"enum " << name
              << ": unknown value {}\", sv);\n";
       source << "  }\n";
+      source << "}\n\n";
+    }
+
+    {
+      header << name << " tag_invoke(boost::json::value_to_tag<" << name
+             << ">, boost::json::value const&);\n";
+
+      source << name << " tag_invoke(boost::json::value_to_tag<" << name
+             << ">, boost::json::value const& jv) {\n";
+      source << "  auto x = " << name << "{};\n";
+      source << "  parse(std::string_view{jv.as_string()}, x);\n";
       source << "  return x;\n";
       source << "}\n\n";
     }
@@ -202,6 +322,44 @@ bool gen_enum(std::string_view type_name,
              << " value {}\", static_cast<int>(v));\n"
              << "}\n\n";
     }
+
+    {
+      header << "\nvoid msgpack_write(openapi::msgpack_writer&, " << name
+             << ");\n"
+             << "void msgpack_read(openapi::msgpack_reader&, " << name
+             << "&);\n\n";
+
+      source << "void msgpack_write(openapi::msgpack_writer& w, " << name
+             << " const v) {\n"
+             << "  if (w.keys_ == openapi::msgpack_keys::kIndices) {\n"
+             << "    w.write_uint(static_cast<std::uint64_t>(v));\n"
+             << "    return;\n"
+             << "  }\n"
+             << "  switch (v) {";
+      auto ind = indent{2, 0};
+      for (auto const& e : enumera) {
+        ind(source);
+        source << "case " << name << "::" << e << ": w.write_string(\"" << e
+               << "\"); return;";
+      }
+      ind(source);
+      source << "}\n";
+      source << "  throw utl::fail(\"invalid " << name
+             << " value {}\", static_cast<int>(v));\n"
+             << "}\n\n";
+
+      source << "void msgpack_read(openapi::msgpack_reader& r, " << name
+             << "& x) {\n"
+             << "  if (r.is_string()) {\n"
+             << "    parse(r.read_string(), x);\n"
+             << "    return;\n"
+             << "  }\n"
+             << "  auto const i = r.read_uint();\n"
+             << "  utl::verify(i < " << enumera.size() << "U, \"enum " << name
+             << ": invalid index {}\", i);\n"
+             << "  x = static_cast<" << name << ">(i);\n"
+             << "}\n\n";
+    }
     return true;
   }
   return false;
@@ -219,6 +377,258 @@ YAML::Node resolve_schema(YAML::Node const& root, YAML::Node const& schema) {
                          : schema;
 }
 
+bool is_ordered_map(YAML::Node const& schema) {
+  auto const ordered = schema["x-ordered"];
+  return ordered.IsDefined() && ordered.as<bool>();
+}
+
+std::string get_map_type(YAML::Node const& root,
+                         std::string_view name,
+                         YAML::Node const& schema) {
+  auto const additional = schema["additionalProperties"];
+  auto const value_type = additional.IsDefined() && additional.IsMap()
+                              ? get_type(root, name, additional)
+                              : std::string{"boost::json::value"};
+  return is_ordered_map(schema)
+             ? "openapi::ordered_map<" + value_type + ">"
+             : std::string{to_cpp(type::kObject)} + "<std::string, " +
+                   value_type + ">";
+}
+
+bool is_enum_set(YAML::Node const& schema) {
+  auto const enum_set = schema["x-enum-set"];
+  return enum_set.IsDefined() && enum_set.as<bool>();
+}
+
+std::string get_enum_set_type(YAML::Node const& root,
+                              std::string_view name,
+                              YAML::Node const& schema) {
+  auto const items = schema["items"];
+  auto const enumera = resolve_schema(root, items)["enum"];
+  utl::verify(enumera.IsDefined() && enumera.size() <= 64U,
+              "x-enum-set {}: items have to be an enum with at most 64 values",
+              name);
+  return get_type(root, name, items) + "Set";
+}
+
+bool is_map(YAML::Node const& schema) {
+  return has_type(schema) && to_type(schema) == type::kObject &&
+         !schema["properties"].IsDefined() && !schema["allOf"].IsDefined();
+}
+
+// additionalProperties next to properties: undeclared members of the JSON
+// object are kept in an additional_ member, typed like a map schema.
+std::optional<YAML::Node> get_additional_schema(YAML::Node const& schema) {
+  auto const additional = schema["additionalProperties"];
+  if (!additional.IsDefined() ||
+      (additional.IsScalar() && !additional.as<bool>())) {
+    return std::nullopt;
+  }
+  auto map = YAML::Node{YAML::NodeType::Map};
+  map["type"] = "object";
+  map["additionalProperties"] = additional;
+  if (is_ordered_map(schema)) {
+    map["x-ordered"] = true;
+  }
+  return map;
+}
+
+// Merges the properties and required lists of all allOf parts (and the
+// schema's own properties) into one plain object schema.
+YAML::Node flatten_all_of(YAML::Node const& root, YAML::Node const& schema) {
+  auto merged = YAML::Node{YAML::NodeType::Map};
+  merged["type"] = "object";
+  auto const merge = [&](YAML::Node const& s) {
+    for (auto const& p : s["properties"]) {
+      merged["properties"][p.first.as<std::string>()] = p.second;
+    }
+    for (auto const& r : s["required"]) {
+      merged["required"].push_back(r);
+    }
+  };
+  for (auto const x :
+       {"x-compact", "x-cpp-borrow", "x-ordered", "additionalProperties"}) {
+    if (schema[x].IsDefined()) {
+      merged[x] = schema[x];
+    }
+  }
+  for (auto const& part : schema["allOf"]) {
+    auto const s = resolve_schema(root, part);
+    merge(s["allOf"].IsDefined() ? flatten_all_of(root, s) : s);
+  }
+  merge(schema);
+  return merged;
+}
+
+bool is_set(YAML::Node const& schema, char const* extension) {
+  auto const x = schema[extension];
+  return x.IsDefined() && x.as<bool>();
+}
+
+bool is_borrowed(YAML::Node const& schema) {
+  return is_set(schema, "x-cpp-borrow");
+}
+
+bool is_interned(YAML::Node const& schema) {
+  return is_set(schema, "x-intern");
+}
+
+void mark_strings(YAML::Node schema, char const* extension) {
+  auto const& s = std::as_const(schema);
+  if (s["$ref"].IsDefined() || !has_type(s)) {
+    return;
+  }
+  switch (to_type(s)) {
+    case type::kString: schema[extension] = true; break;
+    case type::kArray: mark_strings(s["items"], extension); break;
+    default: break;
+  }
+}
+
+// Schema of a struct member: x-cpp-borrow (of the struct or property) and
+// x-intern of a property are applied to all of its strings (including
+// array items). $ref'd schemas need their own.
+YAML::Node get_member_schema(YAML::Node const& schema, bool const borrow) {
+  auto const borrowed = borrow || is_borrowed(schema);
+  auto const interned = is_interned(schema);
+  if (!borrowed && !interned) {
+    return schema;
+  }
+  auto copy = YAML::Clone(schema);
+  if (borrowed) {
+    mark_strings(copy, "x-cpp-borrow");
+  }
+  if (interned) {
+    mark_strings(copy, "x-intern");
+  }
+  return copy;
+}
+
+bool contains_borrowed(YAML::Node const& root,
+                       YAML::Node const& schema,
+                       unsigned const depth = 0U) {
+  auto const s = resolve_schema(root, schema);
+  if (depth > 32U || !has_type(s)) {
+    return false;
+  }
+  switch (to_type(s)) {
+    case type::kString: return is_borrowed(s);
+    case type::kVariant:
+      for (auto const& alternative : get_alternatives(s)) {
+        if (contains_borrowed(root, alternative, depth + 1U)) {
+          return true;
+        }
+      }
+      return false;
+    case type::kObject: {
+      if (is_map(s)) {
+        return false;
+      }
+      auto const flat = s["allOf"].IsDefined() ? flatten_all_of(root, s) : s;
+      if (is_borrowed(flat)) {
+        return true;
+      }
+      for (auto const& p : flat["properties"]) {
+        if (contains_borrowed(root, p.second, depth + 1U)) {
+          return true;
+        }
+      }
+      return false;
+    }
+    case type::kArray: return contains_borrowed(root, s["items"], depth + 1U);
+    default: return false;
+  }
+}
+
+std::string get_variant_type(YAML::Node const& root,
+                             std::string_view name,
+                             YAML::Node const& schema) {
+  auto t = std::string{to_cpp(type::kVariant)} + '<';
+  auto first = true;
+  for (auto const& alternative : get_alternatives(schema)) {
+    if (!first) {
+      t += ", ";
+    }
+    first = false;
+    t += get_type(root, name, alternative);
+  }
+  return t + '>';
+}
+
+bool is_orderable(YAML::Node const& root,
+                  YAML::Node const& schema,
+                  unsigned const depth = 0U) {
+  auto const s = resolve_schema(root, schema);
+  if (depth > 32U || !has_type(s)) {
+    return true;
+  }
+  switch (to_type(s)) {
+    case type::kVariant:
+      for (auto const& alternative : get_alternatives(s)) {
+        if (!is_orderable(root, alternative, depth + 1U)) {
+          return false;
+        }
+      }
+      return true;
+    case type::kObject: {
+      if (is_map(s)) {
+        return false;
+      }
+      auto const flat = s["allOf"].IsDefined() ? flatten_all_of(root, s) : s;
+      if (get_additional_schema(flat).has_value()) {
+        return false;
+      }
+      for (auto const& p : flat["properties"]) {
+        if (!is_orderable(root, p.second, depth + 1U)) {
+          return false;
+        }
+      }
+      return true;
+    }
+    case type::kArray: return is_orderable(root, s["items"], depth + 1U);
+    default: return true;
+  }
+}
+
+bool is_number_array(YAML::Node const& root, YAML::Node const& schema) {
+  auto const s = resolve_schema(root, schema);
+  if (!has_type(s) || to_type(s) != type::kArray) {
+    return false;
+  }
+  auto const items = resolve_schema(root, s["items"]);
+  return has_type(items) && !items["enum"].IsDefined() &&
+         to_type(items) == type::kNumber &&
+         get_number_type(items) == "double";
+}
+
+// Number arrays are decoded from tokens, without a json::array (read_json).
+bool contains_number_array(YAML::Node const& root,
+                           YAML::Node const& schema,
+                           unsigned const depth = 0U) {
+  auto const s = resolve_schema(root, schema);
+  if (depth > 32U || !has_type(s)) {
+    return false;
+  }
+  switch (to_type(s)) {
+    case type::kObject: {
+      if (is_map(s)) {
+        return false;
+      }
+      auto const flat = s["allOf"].IsDefined() ? flatten_all_of(root, s) : s;
+      for (auto const& p : flat["properties"]) {
+        if (contains_number_array(root, p.second, depth + 1U)) {
+          return true;
+        }
+      }
+      return false;
+    }
+    case type::kArray:
+      return is_number_array(root, s) ||
+             contains_number_array(root, s["items"], depth + 1U);
+    default: return false;
+  }
+}
+
 std::string get_type(YAML::Node const& root,
                      std::string_view name,
                      YAML::Node const& schema,
@@ -234,16 +644,96 @@ std::string get_type(YAML::Node const& root,
   }
 
   auto const type = to_type(schema);
+  // Variants get their codec from gen_variant, which needs a named type.
+  utl::verify(type != type::kVariant,
+              "{}: inline oneOf/anyOf is not supported, move it to "
+              "components/schemas and use a $ref",
+              name);
+
   auto const enumera = schema["enum"];
-  auto const t = std::string{enumera.IsDefined() ? std::string{name} + "Enum"
-                                                 : to_cpp(type)};
+  auto const is_number = type == type::kInteger || type == type::kNumber;
+  auto const cpp_type = type != type::kString ? to_cpp(type)
+                        : is_borrowed(schema)  ? "std::string_view"
+                        : is_interned(schema)  ? "openapi::interned_string"
+                                               : to_cpp(type);
+  auto const t = enumera.IsDefined() ? std::string{name} + "Enum"
+                 : is_number         ? std::string{get_number_type(schema)}
+                                     : std::string{cpp_type};
   auto const items = schema["items"];
   auto const has_default = schema["default"].IsDefined();
   auto const x =
-      items.IsDefined() ? t + '<' + get_type(root, name, items) + '>' : t;
+      type == type::kObject ? get_map_type(root, name, schema)
+      : is_enum_set(schema) ? get_enum_set_type(root, name, schema)
+      : items.IsDefined()   ? t + '<' + get_type(root, name, items) + '>'
+                            : t;
   return required || has_default ? x : std::string{"std::optional<"} + x + ">";
 }
 
+bool is_scalar(YAML::Node const& schema) {
+  if (!schema["type"].IsDefined() || schema["enum"].IsDefined()) {
+    return false;
+  }
+  switch (to_type(schema)) {
+    case type::kInteger:
+    case type::kNumber:
+    case type::kBoolean: return true;
+    default: return false;
+  }
+}
+
+bool is_compact(YAML::Node const& schema) {
+  auto const compact = schema["x-compact"];
+  return compact.IsDefined() && compact.as<bool>();
+}
+
+// The sentinel of integers (minimum of signed, maximum of unsigned types) is
+// a valid JSON value: only integers whose schema range excludes it qualify.
+bool excludes_sentinel(YAML::Node const& s) {
+  if (s["enum"].IsDefined() || to_type(s) != type::kInteger) {
+    return true;
+  }
+  auto const cpp_type = get_number_type(s);
+  auto const bits = 8U * get_number_size(cpp_type);
+  if (cpp_type.starts_with("std::uint")) {
+    auto const max = s["maximum"];
+    return max.IsDefined() &&
+           max.as<std::uint64_t>() < (bits == 64U
+                                          ? ~std::uint64_t{0U}
+                                          : (std::uint64_t{1U} << bits) - 1U);
+  }
+  auto const min = s["minimum"];
+  return min.IsDefined() &&
+         (bits == 64U ? min.as<std::int64_t>() !=
+                            std::numeric_limits<std::int64_t>::min()
+                      : min.as<std::int64_t>() >
+                            -(std::int64_t{1} << (bits - 1U)));
+}
+
+// Optional scalars and enums of x-compact schemas are stored as
+// openapi::compact_optional (empty state encoded as a sentinel value).
+bool is_compactable(YAML::Node const& root, YAML::Node const& schema) {
+  auto const s = resolve_schema(root, schema);
+  return has_type(s) && !s["default"].IsDefined() &&
+         !schema["default"].IsDefined() &&
+         (s["enum"].IsDefined() || is_scalar(s)) && excludes_sentinel(s);
+}
+
+// Alignment of the generated member type on LP64 targets.
+std::size_t member_alignment(YAML::Node const& root, YAML::Node const& schema) {
+  auto const s = resolve_schema(root, schema);
+  if (!has_type(s)) {
+    return 8U;
+  } else if (s["enum"].IsDefined()) {
+    return is_small_enum(s["enum"]) ? 1U : 4U;
+  }
+  switch (to_type(s)) {
+    case type::kBoolean: return 1U;
+    case type::kInteger:
+    case type::kNumber: return get_number_size(get_number_type(s));
+    default: return 8U;
+  }
+}
+
 bool is_required(YAML::Node const& n) {
   auto const required = n["required"];
   return required.IsDefined() && required.as<bool>();
@@ -286,8 +776,13 @@ void gen_member(YAML::Node const& root,
                 std::string_view name,
                 bool required,
                 YAML::Node const& schema,
-                std::ostream& out) {
-  out << "  " << get_type(root, name, schema, required) << " " << name << "_{";
+                std::ostream& out,
+                bool const compact = false) {
+  auto const type =
+      compact && !required && is_compactable(root, schema)
+          ? "openapi::compact_optional<" + get_type(root, name, schema) + ">"
+          : get_type(root, name, schema, required);
+  out << "  " << type << " " << name << "_{";
   auto const default_value = schema["default"];
   if (default_value.IsDefined()) {
     gen_value(root, name, schema, default_value, out);
@@ -351,6 +846,22 @@ void write_params(YAML::Node const& root,
   }
   source << "\n  {}\n\n";
 
+  // Back to defaults without giving up string / vector capacity.
+  header << "  void reset();\n";
+  source << "void " << id << "::reset() {\n";
+  for (auto const& p : parameters) {
+    auto const name = p["name"].as<std::string_view>();
+    auto const default_value = p["schema"]["default"];
+    if (default_value.IsDefined()) {
+      source << "  " << name << "_ = decltype(" << name << "_){";
+      gen_value(root, name, p["schema"], default_value, source);
+      source << "};\n";
+    } else {
+      source << "  openapi::clear_param(" << name << "_);\n";
+    }
+  }
+  source << "}\n\n";
+
   if (parameters.IsDefined() && parameters.size() != 0) {
     source << "boost::urls::url " << id
            << "::to_url(std::string_view path) const {\n";
@@ -366,8 +877,8 @@ void write_params(YAML::Node const& root,
       if (is_optional) {
         source << "    if (" << name << "_.has_value()) {\n  ";
       }
-      if (schema["type"].IsDefined() &&
-          schema["type"].as<std::string_view>() == "boolean") {
+      // fmt::streamed would print (u)int8_t as characters.
+      if (is_scalar(schema)) {
         source << "    u.params().append({\"" << name << "\", fmt::to_string("
                << (is_optional ? "*" : "") << name << "_)});\n";
       } else {
@@ -388,17 +899,19 @@ void write_params(YAML::Node const& root,
               "boost::urls::url{path}; }\n";
   }
 
-  header << "  auto cista_members() {\n"
-         << "    return std::tie(\n";
-  for (auto const [i, p] : utl::enumerate(n["parameters"])) {
-    auto const name = p["name"].as<std::string_view>();
-    if (i != 0U) {
-      header << ",\n";
+  for (auto const qualifier : {"", " const"}) {
+    header << "  auto cista_members()" << qualifier << " {\n"
+           << "    return std::tie(\n";
+    for (auto const [i, p] : utl::enumerate(n["parameters"])) {
+      auto const name = p["name"].as<std::string_view>();
+      if (i != 0U) {
+        header << ",\n";
+      }
+      header << "      " << name << "_";
     }
-    header << "      " << name << "_";
+    header << "\n    );\n"
+           << "  }\n\n";
   }
-  header << "\n    );\n"
-         << "  }\n\n";
 
   for (auto const& p : n["parameters"]) {
     auto const name = p["name"].as<std::string_view>();
@@ -407,17 +920,197 @@ void write_params(YAML::Node const& root,
   header << "};\n\n";
 }
 
-void gen_type(std::string_view name,
-              YAML::Node const& root,
-              YAML::Node const& schema,
-              std::ostream& header,
-              std::ostream& source) {
-  if (schema["$ref"].IsDefined()) {
-    return;
+void gen_property_enums(YAML::Node const& schema,
+                        std::ostream& header,
+                        std::ostream& source) {
+  for (auto const& p : schema["properties"]) {
+    auto const prop_name = p.first.as<std::string_view>();
+    auto const& prop_schema = p.second;
+    auto const& items = schema["items"];
+    if (items.IsDefined()) {
+      gen_enum(prop_name, items, header, source);
+    } else {
+      gen_enum(prop_name, prop_schema, header, source);
+    }
+  }
+  if (auto const additional = schema["additionalProperties"];
+      additional.IsDefined() && additional.IsMap()) {
+    gen_enum("additional", additional, header, source);
   }
+}
 
-  auto const type = to_type(schema);
+void gen_variant(std::string_view name,
+                 YAML::Node const& root,
+                 YAML::Node const& schema,
+                 std::ostream& header,
+                 std::ostream& source) {
+  // Alternatives are decoded by trial / value_to, which borrowed types lack.
+  utl::verify(!contains_borrowed(root, schema),
+              "{}: x-cpp-borrow is not supported in oneOf/anyOf", name);
+
+  auto const alternatives = get_alternatives(schema);
+  auto const variant = get_variant_type(root, name, schema);
+
+  header << "struct " << name << " : public " << variant << " {\n"
+         << "  using " << variant << "::variant;\n\n";
+
+  // OSTREAM
+  header << "  friend std::ostream& operator<<(std::ostream&, " << name
+         << " const&);\n";
+  source << "std::ostream& operator<<(std::ostream& out, " << name
+         << " const& x) {\n"
+         << "  return out << "
+            "boost::json::serialize(boost::json::value_from(x));\n"
+         << "}\n\n";
+
+  // Discriminator value -> alternative index. Mapping values come first so
+  // they are used for encoding, schema names are accepted as well.
+  auto const discriminator = schema["discriminator"];
+  auto const property =
+      discriminator.IsDefined()
+          ? std::optional{discriminator["propertyName"].as<std::string>()}
+          : std::nullopt;
+  auto const index_of = [&](std::string_view ref) {
+    auto i = 0U;
+    for (auto const& alternative : alternatives) {
+      if (alternative["$ref"].IsDefined() &&
+          alternative["$ref"].as<std::string_view>() == ref) {
+        return i;
+      }
+      ++i;
+    }
+    throw utl::fail("{}: discriminator mapping {} is not an alternative", name,
+                    ref);
+  };
+  auto values = std::vector<std::pair<std::string, unsigned>>{};
+  if (property.has_value()) {
+    for (auto const& m : discriminator["mapping"]) {
+      values.emplace_back(m.first.as<std::string>(),
+                          index_of(m.second.as<std::string_view>()));
+    }
+    for (auto const& alternative : alternatives) {
+      auto const ref = alternative["$ref"];
+      utl::verify(ref.IsDefined(), "{}: discriminated alternatives need $ref",
+                  name);
+      auto const value = std::string{ref_name(ref)};
+      if (std::ranges::none_of(values,
+                               [&](auto&& v) { return v.first == value; })) {
+        values.emplace_back(value, index_of(ref.as<std::string_view>()));
+      }
+    }
+  }
 
+  // JSON -> TYPE
+  header << "  friend " << name << " tag_invoke(boost::json::value_to_tag<"
+         << name << ">, boost::json::value const&);\n";
+  source << name << " tag_invoke(boost::json::value_to_tag<" << name
+         << ">, boost::json::value const& jv) {\n";
+  if (property.has_value()) {
+    source << "  auto const& o = jv.as_object();\n"
+           << "  auto const it = o.find(\"" << *property << "\");\n"
+           << "  if (it == o.end()) {\n"
+           << "    throw utl::fail(\"" << name << ": " << *property
+           << " not found in {}\", boost::json::serialize(o));\n"
+           << "  }\n"
+           << "  auto const sv = std::string_view{it->value().as_string()};\n"
+           << "  switch (cista::hash(sv)) {";
+    auto ind = indent{2, 0};
+    for (auto const& [value, idx] : values) {
+      ind(source);
+      source << "case cista::hash(\"" << value
+             << "\"): return boost::json::value_to<"
+             << get_type(root, name, alternatives[idx]) << ">(jv);";
+    }
+    ind(source);
+    source << "default: throw utl::fail(\"" << name << ": unknown "
+           << *property << " {}\", sv);\n"
+           << "  }\n";
+  } else {
+    for (auto const& alternative : alternatives) {
+      source << "  try {\n"
+             << "    return boost::json::value_to<"
+             << get_type(root, name, alternative) << ">(jv);\n"
+             << "  } catch (std::exception const&) {\n"
+             << "  }\n";
+    }
+    source << "  throw utl::fail(\"" << name
+           << ": no alternative matches {}\", boost::json::serialize(jv));\n";
+  }
+  source << "}\n\n";
+
+  // TYPE -> JSON
+  header << "  friend void tag_invoke(boost::json::value_from_tag, "
+            "boost::json::value&, "
+         << name << " const&);\n";
+  source << "void tag_invoke(boost::json::value_from_tag, boost::json::value& "
+            "jv, "
+         << name << " const& v) {\n"
+         << "  switch (v.index()) {";
+  auto ind = indent{2, 0};
+  for (auto i = 0U; i != alternatives.size(); ++i) {
+    ind(source);
+    source << "case " << i << "U: jv = boost::json::value_from(std::get<" << i
+           << "U>(v));";
+    auto const value =
+        std::ranges::find_if(values, [&](auto&& v) { return v.second == i; });
+    if (value != end(values)) {
+      source << " jv.as_object()[\"" << *property << "\"] = \""
+             << value->first << "\";";
+    }
+    source << " return;";
+  }
+  ind(source);
+  source << "}\n"
+         << "  throw utl::fail(\"" << name << ": valueless\");\n"
+         << "}\n\n";
+
+  // MSGPACK: [alternative index, value]
+  header << "  friend void msgpack_write(openapi::msgpack_writer&, " << name
+         << " const&);\n"
+         << "  friend void msgpack_read(openapi::msgpack_reader&, " << name
+         << "&);\n";
+  source << "void msgpack_write(openapi::msgpack_writer& w, " << name
+         << " const& v) {\n"
+         << "  utl::verify(!v.valueless_by_exception(), \"" << name
+         << ": valueless\");\n"
+         << "  w.write_array(2U);\n"
+         << "  w.write_uint(v.index());\n"
+         << "  switch (v.index()) {";
+  ind = indent{2, 0};
+  for (auto i = 0U; i != alternatives.size(); ++i) {
+    ind(source);
+    source << "case " << i << "U: openapi::msgpack_write_value(w, std::get<"
+           << i << "U>(v)); return;";
+  }
+  ind(source);
+  source << "}\n"
+         << "}\n\n";
+
+  source << "void msgpack_read(openapi::msgpack_reader& r, " << name
+         << "& v) {\n"
+         << "  utl::verify(r.read_array() == 2U, \"" << name
+         << ": expected [index, value]\");\n"
+         << "  switch (auto const i = r.read_uint(); i) {";
+  ind = indent{2, 0};
+  for (auto i = 0U; i != alternatives.size(); ++i) {
+    ind(source);
+    source << "case " << i << "U: openapi::msgpack_read_value(r, v.emplace<"
+           << i << "U>()); return;";
+  }
+  ind(source);
+  source << "default: throw utl::fail(\"" << name
+         << ": invalid alternative {}\", i);\n"
+         << "  }\n"
+         << "}\n\n";
+
+  header << "};\n\n";
+}
+
+void gen_struct(std::string_view name,
+                YAML::Node const& root,
+                YAML::Node const& schema,
+                std::ostream& header,
+                std::ostream& source) {
   auto const is_in_required_list =
       [&, required = schema["required"]](std::string_view name) {
         if (!required.IsDefined()) {
@@ -431,103 +1124,413 @@ void gen_type(std::string_view name,
         return false;
       };
 
-  if (gen_enum(name, schema, header, source)) {
-    return;
-  }
+  header << "struct " << name << " {\n";
 
-  for (auto const& p : schema["properties"]) {
-    auto const prop_name = p.first.as<std::string_view>();
-    auto const& prop_schema = p.second;
-    auto const& items = schema["items"];
-    if (items.IsDefined()) {
-      gen_enum(prop_name, items, header, source);
-    } else {
-      gen_enum(prop_name, prop_schema, header, source);
-    }
-  }
-
-  switch (type) {
-    case type::kObject:
-      header << "struct " << name << " {\n";
-
-      header << fmt::format(R"(
-  auto operator<=>({} const&) const;
+  header << fmt::format(R"(
   bool operator==({} const&) const;
   bool operator!=({} const&) const;
+)",
+                        name, name);
+
+  source << fmt::format(R"(
+bool {}::operator==({} const&) const = default;
+bool {}::operator!=({} const&) const = default;
+)",
+                        name, name, name, name);
+
+  // Maps and free-form values have no meaningful order.
+  if (is_orderable(root, schema)) {
+    header << fmt::format(R"(  auto operator<=>({} const&) const;
   bool operator<({} const&) const;
   bool operator<=({} const&) const;
   bool operator>({} const&) const;
   bool operator>=({} const&) const;
 )",
-                            name, name, name, name, name, name, name, name,
-                            name, name, name, name, name, name);
+                          name, name, name, name, name);
 
-      source << fmt::format(R"(
-auto {}::operator<=>({} const&) const = default;
-bool {}::operator==({} const&) const = default;
-bool {}::operator!=({} const&) const = default;
+    source << fmt::format(R"(auto {}::operator<=>({} const&) const = default;
 bool {}::operator<({} const&) const = default;
 bool {}::operator<=({} const&) const = default;
 bool {}::operator>({} const&) const = default;
 bool {}::operator>=({} const&) const = default;
 )",
-                            name, name, name, name, name, name, name, name,
-                            name, name, name, name, name, name);
-
-      // OSTREAM
-      header << "  friend std::ostream& operator<<(std::ostream&, " << name
-             << " const&);\n\n";
-      source << "std::ostream& operator<<(std::ostream& out, " << name
-             << " const& x) {\n"
-             << "  return out << "
-                "boost::json::serialize(boost::json::value_from(x));\n"
-             << "}\n\n";
+                          name, name, name, name, name, name, name, name,
+                          name, name);
+  }
 
-      // JSON -> TYPE
-      header << "  friend " << name << " tag_invoke(boost::json::value_to_tag<"
-             << name << ">, boost::json::value const&);\n";
+  // OSTREAM
+  header << "  friend std::ostream& operator<<(std::ostream&, " << name
+         << " const&);\n\n";
+  source << "std::ostream& operator<<(std::ostream& out, " << name
+         << " const& x) {\n"
+         << "  return out << "
+            "boost::json::serialize(boost::json::value_from(x));\n"
+         << "}\n\n";
+
+  struct member {
+    std::string_view name_;
+    bool required_;
+    YAML::Node schema_;
+  };
+  auto const borrow = is_borrowed(schema);
+  auto members = std::vector<member>{};
+  for (auto const& p : schema["properties"]) {
+    auto const member_name = p.first.as<std::string_view>();
+    members.push_back(
+        {member_name,
+         is_in_required_list(member_name) || is_required(p.second),
+         get_member_schema(p.second, borrow)});
+  }
 
-      source << name << " tag_invoke(boost::json::value_to_tag<" << name
-             << ">, "
-                "boost::json::value const& jv) {\n"
-                "    auto v = "
-             << name << "{};\n";
-      for (auto const& p : schema["properties"]) {
-        auto const member_name = p.first.as<std::string_view>();
-        source << "    openapi::extract_member(jv.as_object(), v."
-               << member_name << "_, \"" << member_name << "\");\n";
+  // Not a property: every codec handles it after the declared members.
+  auto const additional = get_additional_schema(schema);
+  utl::verify(!additional.has_value() ||
+                  std::ranges::none_of(members, [](member const& m) {
+                    return m.name_ == "additional";
+                  }),
+              "{}: property \"additional\" clashes with additionalProperties",
+              name);
+
+  // Views into the parsed JSON: only openapi::document<T> may decode them,
+  // all other decoders are deleted.
+  auto const borrowed = contains_borrowed(root, schema);
+
+  // JSON -> TYPE
+  if (borrowed) {
+    header << "  friend " << name << " tag_invoke(boost::json::value_to_tag<"
+           << name << ">, boost::json::value const&) = delete;\n"
+           << "  friend void decode_into(" << name
+           << "&, boost::json::value const&) = delete;\n";
+  } else {
+    header << "  friend " << name << " tag_invoke(boost::json::value_to_tag<"
+           << name << ">, boost::json::value const&);\n"
+           << "  friend void decode_into(" << name
+           << "&, boost::json::value const&);\n";
+
+    source << name << " tag_invoke(boost::json::value_to_tag<" << name
+           << ">, "
+              "boost::json::value const& jv) {\n"
+              "    auto v = "
+           << name
+           << "{};\n"
+              "    decode_into(v, jv);\n"
+              "    return v;\n"
+              "  }\n\n";
+
+    // Overwrites every member in place, reusing their capacity.
+    source << "void decode_into(" << name
+           << "& v, boost::json::value const& jv) {\n"
+              "    auto const& o = jv.as_object();\n";
+    for (auto const& p : schema["properties"]) {
+      auto const member_name = p.first.as<std::string_view>();
+      source << "    openapi::"
+             << (is_number_array(root, p.second) ? "extract_numbers"
+                                                 : "extract_member")
+             << "(o, v." << member_name << "_, \"" << member_name
+             << "\");\n";
+    }
+    if (additional.has_value()) {
+      source << "    static constexpr auto const kNames = "
+                "std::array<std::string_view, "
+             << members.size() << "U>{";
+      for (auto const [i, m] : utl::enumerate(members)) {
+        source << (i == 0U ? "" : ", ") << '"' << m.name_ << '"';
       }
-      source << "    return v;\n"
-                "  }\n\n";
+      source << "};\n"
+             << "    openapi::extract_additional(o, v.additional_, kNames);\n";
+    }
+    source << "  }\n\n";
+  }
 
-      // TYPE -> JSON
-      header << "  friend void tag_invoke(boost::json::value_from_tag, "
-                "boost::json::value& "
-                "jv, "
-             << name << " const& v);\n\n";
+  // JSON text -> TYPE via tokens (openapi::read_json, document<T>).
+  if (borrowed || contains_number_array(root, schema)) {
+    header << "  friend void json_read(openapi::json_token_reader&, " << name
+           << "&);\n";
+
+    // Same structure as msgpack_read, on the tokens of the JSON text.
+    source << "void json_read(openapi::json_token_reader& r, " << name
+           << "& v) {\n"
+           << "  static constexpr auto const kNames = "
+              "std::array<std::string_view, "
+           << members.size() << "U>{";
+    for (auto const [i, m] : utl::enumerate(members)) {
+      source << (i == 0U ? "" : ", ") << '"' << m.name_ << '"';
+    }
+    source << "};\n"
+           << "  auto seen = std::bitset<" << members.size() << "U>{};\n";
+    if (additional.has_value()) {
+      source << "  v.additional_.clear();\n";
+    }
+    source << "  for (auto n = r.read_object(); n != 0U; --n) {\n"
+           << "    auto const i = r.read_key(kNames);\n"
+           << "    switch (i) {\n";
+    for (auto const [i, m] : utl::enumerate(members)) {
+      source << "      case " << i << "U: openapi::json_read_member(r, v."
+             << m.name_ << "_, kNames[" << i << "U]); break;\n";
+    }
+    source << (additional.has_value()
+                   ? "      default: openapi::json_read_additional(r, "
+                     "v.additional_); continue;\n"
+                   : "      default: r.skip(); continue;\n")
+           << "    }\n"
+           << "    seen.set(i);\n"
+           << "  }\n";
+    for (auto const [i, m] : utl::enumerate(members)) {
+      source << "  if (!seen[" << i << "U]) {\n"
+             << "    openapi::json_missing(v." << m.name_ << "_, kNames["
+             << i << "U]);\n"
+             << "  }\n";
+    }
+    source << "}\n\n";
+  }
 
-      source << "void tag_invoke(boost::json::value_from_tag, "
-                "boost::json::value& "
-                "jv, "
-             << name
-             << " const& v) {\n"
-                "    auto& o = (jv = boost::json::object{}).as_object();\n";
-      for (auto const& p : schema["properties"]) {
-        auto const member_name = p.first.as<std::string_view>();
-        source << "    openapi::write_member(o, v." << member_name << "_, \""
-               << member_name << "\");\n";
+  // TYPE -> JSON
+  header << "  friend void tag_invoke(boost::json::value_from_tag, "
+            "boost::json::value& "
+            "jv, "
+         << name << " const& v);\n\n";
+
+  source << "void tag_invoke(boost::json::value_from_tag, "
+            "boost::json::value& "
+            "jv, "
+         << name
+         << " const& v) {\n"
+            "    auto& o = (jv = boost::json::object{}).as_object();\n";
+  for (auto const& p : schema["properties"]) {
+    auto const member_name = p.first.as<std::string_view>();
+    source << "    openapi::write_member(o, v." << member_name << "_, \""
+           << member_name << "\");\n";
+  }
+  if (additional.has_value()) {
+    source << "    openapi::write_additional(o, v.additional_);\n";
+  }
+  source << "  }\n\n";
+
+  // TYPE -> JSON text, member by member (openapi::encode into a sink)
+  header << "  friend void write_json(openapi::json_writer&, " << name
+         << " const&);\n\n";
+
+  source << "void write_json(openapi::json_writer& w, " << name
+         << " const& v) {\n"
+         << "  w.write(\"{\");\n";
+  if (schema["properties"].size() != 0U || additional.has_value()) {
+    source << "  auto first = true;\n";
+  }
+  for (auto const& p : schema["properties"]) {
+    auto const member_name = p.first.as<std::string_view>();
+    source << "  openapi::write_json_member(w, first, v." << member_name
+           << "_, \"" << member_name << "\");\n";
+  }
+  if (additional.has_value()) {
+    source << "  openapi::write_json_additional(w, first, v.additional_);\n";
+  }
+  source << "  w.write(\"}\");\n"
+         << "}\n\n";
+
+  // MERGE PATCH (RFC 7386)
+  header << "  friend void diff_into(boost::json::object&, " << name
+         << " const&, " << name << " const&);\n"
+         << "  friend void patch_into(" << name
+         << "&, boost::json::object const&)"
+         << (borrowed ? " = delete" : "") << ";\n\n";
+
+  source << "void diff_into(boost::json::object& patch, " << name
+         << " const& a, " << name << " const& b) {\n";
+  for (auto const& p : schema["properties"]) {
+    auto const member_name = p.first.as<std::string_view>();
+    source << "  openapi::diff_member(patch, a." << member_name << "_, b."
+           << member_name << "_, \"" << member_name << "\");\n";
+  }
+  if (additional.has_value()) {
+    source << "  openapi::diff_additional(patch, a.additional_, "
+              "b.additional_);\n";
+  }
+  source << "}\n\n";
+
+  if (!borrowed) {
+    source << "void patch_into(" << name
+           << "& v, boost::json::object const& patch) {\n"
+           << "  for (auto const& [key, value] : patch) {\n"
+           << "    switch (cista::hash(std::string_view{key})) {\n";
+    for (auto const& p : schema["properties"]) {
+      auto const member_name = p.first.as<std::string_view>();
+      source << "      case cista::hash(\"" << member_name
+             << "\"): openapi::patch_member(v." << member_name
+             << "_, value, \"" << member_name << "\"); break;\n";
+    }
+    source << (additional.has_value()
+                   ? "      default: openapi::patch_additional(v.additional_, "
+                     "key, value); break;\n"
+                   : "      default: break;\n")
+           << "    }\n"
+           << "  }\n"
+           << "}\n\n";
+  }
+
+  // CONTENT HASH (ETag)
+  header << "  friend void hash_value(openapi::content_hash&, " << name
+         << " const&);\n\n";
+
+  source << "void hash_value(openapi::content_hash& h, " << name
+         << " const& v) {\n";
+  for (auto const& p : schema["properties"]) {
+    source << "  openapi::hash_member(h, v." << p.first.as<std::string_view>()
+           << "_);\n";
+  }
+  if (additional.has_value()) {
+    source << "  openapi::hash_member(h, v.additional_);\n";
+  }
+  source << "}\n\n";
+
+  // MSGPACK: map keyed by property name or index (spec order)
+  header << "\n  friend void msgpack_write(openapi::msgpack_writer&, " << name
+         << " const&);\n"
+         << "  friend void msgpack_read(openapi::msgpack_reader&, " << name
+         << "&)" << (borrowed ? " = delete" : "") << ";\n\n";
+
+  source << "void msgpack_write(openapi::msgpack_writer& w, " << name
+         << " const& v) {\n"
+         << "  w.write_map(0U";
+  for (auto const& m : members) {
+    source << " + openapi::msgpack_present(v." << m.name_ << "_)";
+  }
+  if (additional.has_value()) {
+    source << " + v.additional_.size()";
+  }
+  source << ");\n";
+  for (auto const [i, m] : utl::enumerate(members)) {
+    source << "  openapi::msgpack_write_member(w, " << i << "U, \"" << m.name_
+           << "\", v." << m.name_ << "_);\n";
+  }
+  if (additional.has_value()) {
+    source << "  openapi::msgpack_write_additional(w, v.additional_);\n";
+  }
+  source << "}\n\n";
+
+  if (!borrowed) {
+    source << "void msgpack_read(openapi::msgpack_reader& r, " << name
+           << "& v) {\n"
+           << "  static constexpr auto const kNames = "
+              "std::array<std::string_view, "
+           << members.size() << "U>{";
+    for (auto const [i, m] : utl::enumerate(members)) {
+      source << (i == 0U ? "" : ", ") << '"' << m.name_ << '"';
+    }
+    source << "};\n"
+           << "  auto seen = std::bitset<" << members.size() << "U>{};\n";
+    if (additional.has_value()) {
+      source << "  v.additional_.clear();\n";
+    }
+    source << "  for (auto n = r.read_map(); n != 0U; --n) {\n"
+           << "    auto const i = r.read_key(kNames);\n"
+           << "    switch (i) {\n";
+    for (auto const [i, m] : utl::enumerate(members)) {
+      source << "      case " << i << "U: openapi::msgpack_read_value(r, v."
+             << m.name_ << "_); break;\n";
+    }
+    source << (additional.has_value()
+                   ? "      default: openapi::msgpack_read_additional(r, "
+                     "v.additional_); continue;\n"
+                   : "      default: r.skip(); continue;\n")
+           << "    }\n"
+           << "    seen.set(i);\n"
+           << "  }\n";
+    for (auto const [i, m] : utl::enumerate(members)) {
+      source << "  if (!seen[" << i << "U]) {\n"
+             << "    openapi::msgpack_missing(v." << m.name_ << "_, \"" << name
+             << "\", \"" << m.name_ << "\");\n"
+             << "  }\n";
+    }
+    source << "}\n\n";
+  }
+
+  if (!is_compact(schema)) {
+    for (auto const& m : members) {
+      gen_member(root, m.name_, m.required_, m.schema_, header);
+    }
+    if (additional.has_value()) {
+      gen_member(root, "additional", true, *additional, header);
+    }
+    header << "};\n\n";
+    return;
+  }
+
+  // Spec order layout, only used for write_layout_report.
+  source << "namespace {\n\n"
+         << "struct " << name << "_spec_order {\n";
+  for (auto const& m : members) {
+    gen_member(root, m.name_, m.required_, m.schema_, source);
+  }
+  if (additional.has_value()) {
+    gen_member(root, "additional", true, *additional, source);
+  }
+  source << "};\n\n"
+         << "}  // namespace\n\n";
+
+  // Storage sorted by alignment to avoid padding, JSON keeps the spec order.
+  // (Sorting indices: assigning a YAML::Node would overwrite the node.)
+  auto order = std::vector<std::size_t>(members.size());
+  std::iota(begin(order), end(order), std::size_t{0U});
+  std::ranges::stable_sort(order, std::greater<>{}, [&](std::size_t const i) {
+    return member_alignment(root, members[i].schema_);
+  });
+  header << "  // x-compact: members sorted by alignment\n";
+  if (additional.has_value()) {
+    gen_member(root, "additional", true, *additional, header);
+  }
+  for (auto const i : order) {
+    auto const& m = members[i];
+    gen_member(root, m.name_, m.required_, m.schema_, header, true);
+  }
+  header << "};\n\n";
+}
+
+void gen_type(std::string_view name,
+              YAML::Node const& root,
+              YAML::Node const& schema,
+              std::ostream& header,
+              std::ostream& source) {
+  if (schema["$ref"].IsDefined()) {
+    return;
+  }
+
+  if (schema["allOf"].IsDefined()) {
+    // Enums of referenced parts are generated with the referenced schema.
+    for (auto const& part : schema["allOf"]) {
+      if (!part["$ref"].IsDefined()) {
+        gen_property_enums(part, header, source);
       }
-      source << "  }\n\n";
+    }
+    gen_property_enums(schema, header, source);
+    gen_struct(name, root, flatten_all_of(root, schema), header, source);
+    return;
+  }
+
+  auto const type = to_type(schema);
 
-      for (auto const& p : schema["properties"]) {
-        auto const member_name = p.first.as<std::string_view>();
-        auto const required =
-            is_in_required_list(member_name) || is_required(p.second);
-        gen_member(root, member_name, required, p.second, header);
+  if (gen_enum(name, schema, header, source)) {
+    return;
+  }
+
+  gen_property_enums(schema, header, source);
+
+  switch (type) {
+    case type::kObject:
+      if (is_map(schema)) {
+        auto const additional = schema["additionalProperties"];
+        if (additional.IsDefined() && additional.IsMap()) {
+          gen_enum(name, additional, header, source);
+        }
+        header << "using " << name << " = " << get_type(root, name, schema)
+               << ";\n\n";
+        break;
       }
-      header << "};\n\n";
+
+      gen_struct(name, root, schema, header, source);
       break;
 
+    case type::kVariant: gen_variant(name, root, schema, header, source); break;
+
     case type::kArray:
       gen_enum(std::string{name}, schema["items"], header, source);
       [[fallthrough]];
@@ -539,6 +1542,213 @@ bool {}::operator>=({} const&) const = default;
   }
 }
 
+bool is_struct(YAML::Node const& schema) {
+  return !schema["$ref"].IsDefined() &&
+         (schema["allOf"].IsDefined() ||
+          (has_type(schema) && !schema["enum"].IsDefined() &&
+           to_type(schema) == type::kObject && !is_map(schema)));
+}
+
+void write_layout_report(
+    std::vector<std::pair<std::string, bool>> const& structs,
+    std::ostream& header,
+    std::ostream& source) {
+  header << "// sizeof of all structs: spec order -> as generated (only\n"
+         << "// x-compact structs differ).\n"
+         << "std::ostream& write_layout_report(std::ostream&);\n\n";
+  source << "std::ostream& write_layout_report(std::ostream& out) {\n";
+  for (auto const& [name, compact] : structs) {
+    source << "  out << \"" << name << ": \" << sizeof(" << name
+           << (compact ? "_spec_order" : "") << ") << \" -> \" << sizeof("
+           << name << ") << \" bytes\\n\";\n";
+  }
+  source << "  return out;\n"
+         << "}\n\n";
+}
+
+// Schema of the application/json content of a requestBody or response.
+YAML::Node get_json_schema(YAML::Node const& n) {
+  auto const undefined = YAML::Node{YAML::NodeType::Undefined};
+  if (!n.IsDefined() || !n["content"].IsDefined()) {
+    return undefined;
+  }
+  auto const json = n["content"]["application/json"];
+  return json.IsDefined() ? json["schema"] : undefined;
+}
+
+std::string schema_type(YAML::Node const& root,
+                        std::string const& name,
+                        YAML::Node const& schema) {
+  return schema["$ref"].IsDefined() ? get_type(root, name, schema) : name;
+}
+
+void write_operation(YAML::Node const& root,
+                     YAML::Node const& n,
+                     std::ostream& header,
+                     std::ostream& source) {
+  auto const op = n["operationId"].as<std::string>();
+
+  header << op << "_params parse_" << op
+         << "_params(boost::urls::params_view const&, bool allow_missing = "
+            "false);\n";
+  source << op << "_params parse_" << op
+         << "_params(boost::urls::params_view const& params, bool const "
+            "allow_missing) {\n"
+         << "  OPENAPI_METRICS_SCOPE(\"" << op << "\", stage::kParams);\n"
+         << "  return " << op << "_params{params, allow_missing};\n"
+         << "}\n\n";
+
+  auto const body = get_json_schema(n["requestBody"]);
+  if (body.IsDefined()) {
+    // Borrowed string views need the parsed document to stay alive, number
+    // arrays are read from tokens instead of a json::array.
+    auto const type = schema_type(root, op + "_body", body);
+    auto const borrowed = contains_borrowed(root, body);
+    auto const numbers = contains_number_array(root, body);
+    auto const result =
+        borrowed ? "openapi::document<" + type + ">" : type;
+    header << result << " decode_" << op << "_body(std::string_view);\n";
+    source << result << " decode_" << op << "_body(std::string_view s) {\n"
+           << "  OPENAPI_METRICS_SCOPE(\"" << op << "\", stage::kDecode);\n"
+           << "  OPENAPI_METRICS_BYTES(s.size());\n";
+    if (borrowed) {
+      source << "  return " << result << "{s};\n";
+    } else if (numbers) {
+      source << "  return openapi::read_json<" << type << ">(s);\n";
+    } else {
+      source << "  return boost::json::value_to<" << type
+             << ">(boost::json::parse(s));\n";
+    }
+    source << "}\n\n";
+
+    if (!borrowed) {
+      header << "void decode_" << op << "_body_into(" << type
+             << "&, std::string_view);\n";
+      source << "void decode_" << op << "_body_into(" << type
+             << "& v, std::string_view s) {\n"
+             << "  OPENAPI_METRICS_SCOPE(\"" << op << "\", stage::kDecode);\n"
+             << "  OPENAPI_METRICS_BYTES(s.size());\n"
+             << "  openapi::" << (numbers ? "read_json_into" : "parse_into")
+             << "(v, s);\n"
+             << "}\n\n";
+
+      // MessagePack views would point into the caller's buffer.
+      header << type << " decode_" << op
+             << "_body(std::string_view, openapi::wire_format);\n";
+      source << type << " decode_" << op
+             << "_body(std::string_view s, openapi::wire_format const f) {\n"
+             << "  if (f == openapi::wire_format::kJson) {\n"
+             << "    return decode_" << op << "_body(s);\n"
+             << "  }\n"
+             << "  OPENAPI_METRICS_SCOPE(\"" << op << "\", stage::kDecode);\n"
+             << "  OPENAPI_METRICS_BYTES(s.size());\n"
+             << "  return openapi::from_msgpack<" << type << ">(s);\n"
+             << "}\n\n";
+    }
+  }
+
+  for (auto const& response : n["responses"]) {
+    auto const schema = get_json_schema(response.second);
+    if (!schema.IsDefined()) {
+      continue;
+    }
+    auto const type = schema_type(root, op + "_response", schema);
+    header << "std::string encode_" << op << "_response(" << type
+           << " const&);\n";
+    source << "std::string encode_" << op << "_response(" << type
+           << " const& x) {\n"
+           << "  OPENAPI_METRICS_SCOPE(\"" << op << "\", stage::kEncode);\n"
+           << "  auto s = boost::json::serialize(boost::json::value_from(x));\n"
+           << "  OPENAPI_METRICS_BYTES(s.size());\n"
+           << "  return s;\n"
+           << "}\n\n";
+
+    // Streams into the sink (e.g. openapi::zlib_sink), returns the JSON size.
+    header << "std::size_t encode_" << op << "_response(" << type
+           << " const&, openapi::sink&);\n";
+    source << "std::size_t encode_" << op << "_response(" << type
+           << " const& x, openapi::sink& out) {\n"
+           << "  OPENAPI_METRICS_SCOPE(\"" << op << "\", stage::kEncode);\n"
+           << "  auto const size = openapi::encode(x, out);\n"
+           << "  OPENAPI_METRICS_BYTES(size);\n"
+           << "  return size;\n"
+           << "}\n\n";
+
+    // ETag without encoding (If-None-Match -> 304): one hash pass over the
+    // values, the only allocation is the returned header value.
+    header << "std::string " << op << "_response_etag(" << type
+           << " const&);\n";
+    source << "std::string " << op << "_response_etag(" << type
+           << " const& x) {\n"
+           << "  return openapi::etag_of(x);\n"
+           << "}\n\n";
+
+    // Convenience for 200 responses: hash pass + encoding, two walks. The
+    // ETag is not taken from the encoder output, it has to match the one of
+    // _response_etag, which is independent of map order and wire format.
+    header << "std::string encode_" << op << "_response(" << type
+           << " const&, std::string& etag);\n";
+    source << "std::string encode_" << op << "_response(" << type
+           << " const& x, std::string& etag) {\n"
+           << "  etag = openapi::etag_of(x);\n"
+           << "  return encode_" << op << "_response(x);\n"
+           << "}\n\n";
+
+    // Merge patch against a previously sent response.
+    header << "std::string encode_" << op << "_response_patch(" << type
+           << " const& from, " << type << " const& to);\n";
+    source << "std::string encode_" << op << "_response_patch(" << type
+           << " const& from, " << type << " const& to) {\n"
+           << "  OPENAPI_METRICS_SCOPE(\"" << op << "\", stage::kEncode);\n"
+           << "  auto s = boost::json::serialize(openapi::diff(from, to));\n"
+           << "  OPENAPI_METRICS_BYTES(s.size());\n"
+           << "  return s;\n"
+           << "}\n\n";
+
+    // Large arrays are encoded in chunks on the pool.
+    auto const resolved = resolve_schema(root, schema);
+    if (has_type(resolved) && to_type(resolved) == type::kArray &&
+        !is_enum_set(resolved)) {
+      header << "std::string encode_" << op << "_response(" << type
+             << " const&, openapi::encode_pool&);\n";
+      source << "std::string encode_" << op << "_response(" << type
+             << " const& x, openapi::encode_pool& pool) {\n"
+             << "  OPENAPI_METRICS_SCOPE(\"" << op << "\", stage::kEncode);\n"
+             << "  auto s = openapi::encode_array(x, pool);\n"
+             << "  OPENAPI_METRICS_BYTES(s.size());\n"
+             << "  return s;\n"
+             << "}\n\n";
+
+      header << "std::vector<std::string> encode_" << op
+             << "_response_chunks(" << type
+             << " const&, openapi::encode_pool&);\n";
+      source << "std::vector<std::string> encode_" << op
+             << "_response_chunks(" << type
+             << " const& x, openapi::encode_pool& pool) {\n"
+             << "  OPENAPI_METRICS_SCOPE(\"" << op << "\", stage::kEncode);\n"
+             << "  auto chunks = openapi::encode_array_chunks(x, pool);\n"
+             << "  OPENAPI_METRICS_BYTES(openapi::total_size(chunks));\n"
+             << "  return chunks;\n"
+             << "}\n\n";
+    }
+
+    header << "std::string encode_" << op << "_response(" << type
+           << " const&, openapi::wire_format);\n";
+    source << "std::string encode_" << op << "_response(" << type
+           << " const& x, openapi::wire_format const f) {\n"
+           << "  if (f == openapi::wire_format::kJson) {\n"
+           << "    return encode_" << op << "_response(x);\n"
+           << "  }\n"
+           << "  OPENAPI_METRICS_SCOPE(\"" << op << "\", stage::kEncode);\n"
+           << "  auto s = openapi::to_msgpack(x);\n"
+           << "  OPENAPI_METRICS_BYTES(s.size());\n"
+           << "  return s;\n"
+           << "}\n\n";
+    break;
+  }
+  header << "\n";
+}
+
 void write_types(YAML::Node const& root,
                  std::string_view path_to_header,
                  std::ostream& header,
@@ -546,10 +1756,18 @@ void write_types(YAML::Node const& root,
                  std::optional<std::string_view> ns) {
   write_prelude(path_to_header, header, source, ns);
 
+  auto structs = std::vector<std::pair<std::string, bool>>{};
+  auto const gen = [&](std::string const& name, YAML::Node const& schema) {
+    gen_type(name, root, schema, header, source);
+    if (is_struct(schema)) {
+      structs.emplace_back(name, is_compact(schema));
+    }
+  };
+
   auto const components = root["components"];
   if (components.IsDefined()) {
     for (auto const& c : components["schemas"]) {
-      gen_type(c.first.as<std::string_view>(), root, c.second, header, source);
+      gen(c.first.as<std::string>(), c.second);
     }
   }
 
@@ -558,13 +1776,24 @@ void write_types(YAML::Node const& root,
       write_params(root, method.second, header, source);
 
       for (auto const& response : method.second["responses"]) {
-        gen_type(method.second["operationId"].as<std::string>() + "_response",
-                 root, response.second["content"]["application/json"]["schema"],
-                 header, source);
+        auto const schema = get_json_schema(response.second);
+        if (schema.IsDefined()) {
+          gen(method.second["operationId"].as<std::string>() + "_response",
+              schema);
+        }
+      }
+
+      auto const body = get_json_schema(method.second["requestBody"]);
+      if (body.IsDefined()) {
+        gen(method.second["operationId"].as<std::string>() + "_body", body);
       }
+
+      write_operation(root, method.second, header, source);
     }
   }
 
+  write_layout_report(structs, header, source);
+
   write_postlude(header, source, ns);
 }
 
@@ -0,0 +1,38 @@
+#include "openapi/intern.h"
+
+namespace openapi {
+
+namespace {
+
+thread_local intern_pool* current = nullptr;
+
+}  // namespace
+
+std::shared_ptr<std::string const> intern_pool::get(std::string_view s) {
+  if (auto const it = strings_.find(s); it != strings_.end()) {
+    ++hits_;
+    return it->second;
+  }
+  auto p = std::make_shared<std::string const>(s);
+  strings_.emplace(std::string_view{*p}, p);
+  return p;
+}
+
+void intern_pool::clear() {
+  strings_.clear();
+  hits_ = 0U;
+}
+
+intern_scope::intern_scope(intern_pool& pool) : prev_{current} {
+  current = &pool;
+}
+
+intern_scope::~intern_scope() { current = prev_; }
+
+intern_pool* current_intern_pool() { return current; }
+
+interned_string::interned_string(std::string_view s)
+    : p_{current == nullptr ? std::make_shared<std::string const>(s)
+                            : current->get(s)} {}
+
+}  // namespace openapi
@@ -1,9 +1,122 @@
 #include "openapi/json.h"
 
-#include "fmt/chrono.h"
+#include <algorithm>
+#include <memory>
+#include <string_view>
+
+#include "fmt/format.h"
 
 namespace openapi {
 
+namespace {
+
+// Bump allocator that keeps its memory: release() merges all blocks into
+// one, so the next document of similar size fits without allocating.
+struct scratch_resource final : public json::memory_resource {
+  static constexpr auto const kMinBlockSize = std::size_t{4096U};
+
+  void release() {
+    if (blocks_.size() > 1U) {
+      auto total = std::size_t{0U};
+      for (auto const& b : blocks_) {
+        total += b.size_;
+      }
+      blocks_.clear();
+      add_block(total);
+    }
+    used_ = 0U;
+  }
+
+  void* do_allocate(std::size_t const n, std::size_t const align) override {
+    if (!blocks_.empty()) {
+      auto& b = blocks_.back();
+      auto const offset = (used_ + align - 1U) / align * align;
+      if (offset + n <= b.size_) {
+        used_ = offset + n;
+        return b.data_.get() + offset;
+      }
+    }
+    auto const next =
+        blocks_.empty() ? kMinBlockSize : 2U * blocks_.back().size_;
+    add_block(std::max(next, n + align));
+    return do_allocate(n, align);
+  }
+
+  void do_deallocate(void*, std::size_t, std::size_t) override {}
+
+  bool do_is_equal(json::memory_resource const& o) const noexcept override {
+    return this == &o;
+  }
+
+private:
+  struct block {
+    std::unique_ptr<unsigned char[]> data_;
+    std::size_t size_;
+  };
+
+  void add_block(std::size_t const size) {
+    blocks_.push_back({std::make_unique_for_overwrite<unsigned char[]>(size),
+                       size});
+    used_ = 0U;
+  }
+
+  std::vector<block> blocks_;
+  std::size_t used_{0U};
+};
+
+// what() of a nested error is either "<pointer>: message" or (not thrown by
+// the decoders here, e.g. json::value::as_object) just "message".
+[[noreturn]] void rethrow_at_segment(std::string_view const segment,
+                                     std::exception const& e) {
+  auto const what = std::string_view{e.what()};
+  if (what.starts_with("/:")) {
+    throw utl::fail("/{}{}", segment, what.substr(1U));
+  } else if (what.starts_with('/')) {
+    throw utl::fail("/{}{}", segment, what);
+  }
+  throw utl::fail("/{}: {}", segment, what);
+}
+
+}  // namespace
+
+void rethrow_at(std::string_view const member, std::exception const& e) {
+  rethrow_at_segment(member, e);
+}
+
+void rethrow_at(std::size_t const index, std::exception const& e) {
+  rethrow_at_segment(fmt::to_string(index), e);
+}
+
+void read_numbers(json::array const& arr, std::vector<double>& v) {
+  v.resize(arr.size());
+  auto out = v.data();
+  for (auto const& x : arr) {
+    switch (x.kind()) {
+      case json::kind::double_: *out = x.get_double(); break;
+      case json::kind::int64: *out = static_cast<double>(x.get_int64()); break;
+      case json::kind::uint64:
+        *out = static_cast<double>(x.get_uint64());
+        break;
+      default:
+        throw utl::fail("/{}: expected number, got {}", out - v.data(),
+                        json::serialize(x));
+    }
+    ++out;
+  }
+}
+
+json::value const& parse_temporary(std::string_view s) {
+  thread_local auto scratch = scratch_resource{};
+  thread_local auto parser = json::parser{};
+  thread_local auto doc = std::optional<json::value>{};
+
+  doc.reset();
+  scratch.release();
+  parser.reset(&scratch);
+  parser.write(s);
+  return doc.emplace(parser.release());
+}
+
 date_time_t tag_invoke(json::value_to_tag<date_time_t>, json::value const& jv) {
   auto d = date_time_t{};
   parse(jv.as_string(), d);
@@ -11,13 +124,7 @@ date_time_t tag_invoke(json::value_to_tag<date_time_t>, json::value const& jv) {
 }
 
 void tag_invoke(json::value_from_tag, json::value& jv, date_time_t const v) {
-  auto const offset_total_minutes = v.offset_.count();
-  auto const offset_hours = offset_total_minutes / 60;
-  auto const offset_minutes = std::abs(offset_total_minutes % 60);
-  jv = v.offset_.count() == 0
-           ? fmt::format("{:%FT%T}Z", v.time_)
-           : fmt::format("{:%FT%T}{:+03d}:{:02d}", v.time_ + v.offset_,
-                         offset_hours, offset_minutes);
+  jv = to_str(v);
 }
 
-}  // namespace openapi
\ No newline at end of file
+}  // namespace openapi
@@ -0,0 +1,430 @@
+#include "openapi/load_spec.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <exception>
+#include <fstream>
+#include <iterator>
+#include <optional>
+#include <random>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#include "boost/json.hpp"
+#include "boost/unordered/unordered_flat_map.hpp"
+
+#include "fmt/format.h"
+
+#include "cista/containers/string.h"
+#include "cista/containers/vector.h"
+#include "cista/hash.h"
+#include "cista/serialization.h"
+
+#include "utl/verify.h"
+
+namespace fs = std::filesystem;
+namespace json = boost::json;
+
+namespace openapi {
+
+namespace {
+
+namespace data = cista::offset;
+
+constexpr auto const kMode =
+    cista::mode::WITH_VERSION | cista::mode::WITH_INTEGRITY;
+
+enum class node_kind : std::uint8_t { kNull, kScalar, kSequence, kMap };
+
+// Children of a node are children_[begin_, end_), alternating key and value
+// for maps.
+struct tree_node {
+  node_kind kind_{node_kind::kNull};
+  data::string value_;
+  std::uint32_t begin_{0U}, end_{0U};
+};
+
+struct dependency {
+  data::string path_;
+  cista::hash_t hash_{0U};
+};
+
+// YAML document, nodes_[0] is the root. deps_ lists the files (and their
+// content hashes) a resolved document was built from.
+struct tree {
+  data::vector<dependency> deps_;
+  data::vector<tree_node> nodes_;
+  data::vector<std::uint32_t> children_;
+};
+
+std::uint32_t add_node(tree& t, YAML::Node const& n) {
+  auto const i = static_cast<std::uint32_t>(t.nodes_.size());
+  t.nodes_.emplace_back();
+
+  auto children = std::vector<std::uint32_t>{};
+  switch (n.Type()) {
+    case YAML::NodeType::Scalar:
+      t.nodes_[i].kind_ = node_kind::kScalar;
+      t.nodes_[i].value_.set_owning(n.Scalar());
+      break;
+
+    case YAML::NodeType::Sequence:
+      t.nodes_[i].kind_ = node_kind::kSequence;
+      for (auto const& x : n) {
+        children.push_back(add_node(t, x));
+      }
+      break;
+
+    case YAML::NodeType::Map:
+      t.nodes_[i].kind_ = node_kind::kMap;
+      for (auto const& x : n) {
+        children.push_back(add_node(t, x.first));
+        children.push_back(add_node(t, x.second));
+      }
+      break;
+
+    default: break;
+  }
+
+  t.nodes_[i].begin_ = static_cast<std::uint32_t>(t.children_.size());
+  for (auto const c : children) {
+    t.children_.push_back(c);
+  }
+  t.nodes_[i].end_ = static_cast<std::uint32_t>(t.children_.size());
+  return i;
+}
+
+tree flatten(YAML::Node const& doc,
+             std::vector<std::pair<std::string, cista::hash_t>> const& deps) {
+  auto t = tree{};
+  for (auto const& [path, hash] : deps) {
+    auto dep = dependency{.hash_ = hash};
+    dep.path_.set_owning(path);
+    t.deps_.push_back(dep);
+  }
+  add_node(t, doc);
+  return t;
+}
+
+YAML::Node unflatten(tree const& t, std::uint32_t const i) {
+  auto const& n = t.nodes_[i];
+  switch (n.kind_) {
+    case node_kind::kScalar: return YAML::Node{std::string{n.value_.view()}};
+
+    case node_kind::kSequence: {
+      auto seq = YAML::Node{YAML::NodeType::Sequence};
+      for (auto c = n.begin_; c != n.end_; ++c) {
+        seq.push_back(unflatten(t, t.children_[c]));
+      }
+      return seq;
+    }
+
+    case node_kind::kMap: {
+      auto map = YAML::Node{YAML::NodeType::Map};
+      for (auto c = n.begin_; c != n.end_; c += 2U) {
+        auto const& key = t.nodes_[t.children_[c]];
+        map[std::string{key.value_.view()}] = unflatten(t, t.children_[c + 1U]);
+      }
+      return map;
+    }
+
+    default: return YAML::Node{YAML::NodeType::Null};
+  }
+}
+
+std::string read_file(fs::path const& p) {
+  auto in = std::ifstream{p, std::ios::binary};
+  utl::verify(in.is_open(), "load_spec: cannot open {}", p.string());
+  return {std::istreambuf_iterator<char>{in}, std::istreambuf_iterator<char>{}};
+}
+
+bool is_up_to_date(tree const& t) {
+  for (auto const& dep : t.deps_) {
+    auto const p = fs::path{std::string{dep.path_.view()}};
+    if (!fs::exists(p) || cista::hash(read_file(p)) != dep.hash_) {
+      return false;
+    }
+  }
+  return true;
+}
+
+// Cached document if present, written by the same version and (for
+// resolved documents) built from the current file contents. The files it
+// was built from are appended to `deps`.
+std::optional<YAML::Node> read_tree(fs::path const& p,
+                                    std::vector<fs::path>* deps = nullptr) {
+  auto in = std::ifstream{p, std::ios::binary};
+  if (!in.is_open()) {
+    return std::nullopt;
+  }
+  auto buf = cista::byte_buf{std::istreambuf_iterator<char>{in},
+                             std::istreambuf_iterator<char>{}};
+  try {
+    auto const t = cista::deserialize<tree, kMode>(buf);
+    if (!is_up_to_date(*t)) {
+      return std::nullopt;
+    }
+    if (deps != nullptr) {
+      for (auto const& dep : t->deps_) {
+        deps->emplace_back(std::string{dep.path_.view()});
+      }
+    }
+    return unflatten(*t, 0U);
+  } catch (std::exception const&) {
+    return std::nullopt;
+  }
+}
+
+// Write + rename: concurrent runs never see a partially written file.
+void write_tree(fs::path const& p, tree& t) {
+  auto const buf = cista::serialize<kMode>(t);
+  auto const tmp =
+      fs::path{p}.concat(fmt::format(".{}", std::random_device{}()));
+  {
+    auto out = std::ofstream{tmp, std::ios::binary};
+    out.write(reinterpret_cast<char const*>(buf.data()),
+              static_cast<std::streamsize>(buf.size()));
+  }
+  fs::rename(tmp, p);
+}
+
+YAML::Node parse(fs::path const& p, std::string const& content) {
+  return p.extension() == ".json" ? to_yaml(json::parse(content))
+                                  : YAML::Load(content);
+}
+
+// JSON pointer (RFC 6901) into a document.
+YAML::Node navigate(YAML::Node const& doc,
+                    std::string_view pointer,
+                    std::string_view ref) {
+  auto node = doc;
+  while (!pointer.empty()) {
+    pointer.remove_prefix(1U);
+    auto const end = pointer.find('/');
+    auto token = std::string{pointer.substr(0U, end)};
+    pointer = end == std::string_view::npos ? "" : pointer.substr(end);
+
+    for (auto pos = token.find('~'); pos != std::string::npos;
+         pos = token.find('~', pos + 1U)) {
+      token.replace(pos, 2U, token.compare(pos, 2U, "~1") == 0 ? "/" : "~");
+    }
+
+    auto const& cur = static_cast<YAML::Node const&>(node);
+    auto const next = cur.IsSequence() ? cur[std::stoul(token)] : cur[token];
+    utl::verify(next.IsDefined(), "load_spec: {} not found", ref);
+    node.reset(next);
+  }
+  return node;
+}
+
+// Map entry without inserting it, undefined if `n` is no map or has no `key`.
+YAML::Node child(YAML::Node const& n, std::string const& key) {
+  return n.IsDefined() && n.IsMap() ? n[key]
+                                    : YAML::Node{YAML::NodeType::Undefined};
+}
+
+// Components section of the objects below `key`, empty: same as the parent.
+std::string_view section_of(std::string_view const key) {
+  switch (cista::hash(key)) {
+    case cista::hash("schema"):
+    case cista::hash("schemas"): return "schemas";
+    case cista::hash("parameters"): return "parameters";
+    case cista::hash("responses"): return "responses";
+    case cista::hash("requestBody"):
+    case cista::hash("requestBodies"): return "requestBodies";
+    case cista::hash("headers"): return "headers";
+    case cista::hash("examples"): return "examples";
+    case cista::hash("links"): return "links";
+    case cista::hash("callbacks"): return "callbacks";
+    case cista::hash("securitySchemes"): return "securitySchemes";
+    default: return "";
+  }
+}
+
+// "/components/parameters/limit" -> "parameters", empty for other pointers.
+std::string_view pointer_section(std::string_view pointer) {
+  constexpr auto const kPrefix = std::string_view{"/components/"};
+  if (!pointer.starts_with(kPrefix)) {
+    return "";
+  }
+  pointer.remove_prefix(kPrefix.size());
+  auto const end = pointer.find('/');
+  return end == std::string_view::npos ? "" : pointer.substr(0U, end);
+}
+
+struct component {
+  std::string section_, name_;
+  YAML::Node node_;
+};
+
+struct loader {
+  YAML::Node file(fs::path const& p) {
+    auto const key = p.string();
+    if (auto const it = files_.find(key); it != end(files_)) {
+      return it->second;
+    }
+
+    auto const content = read_file(p);
+    auto const hash = cista::hash(content);
+    deps_.emplace_back(key, hash);
+
+    auto const cached =
+        cache_dir_.has_value()
+            ? std::optional{*cache_dir_ /
+                            fmt::format("{:016x}{}.tree", hash,
+                                        p.extension().string())}
+            : std::nullopt;
+    auto doc = cached.has_value() ? read_tree(*cached) : std::nullopt;
+    if (!doc.has_value()) {
+      doc = parse(p, content);
+      if (cached.has_value()) {
+        auto t = flatten(*doc, {});
+        write_tree(*cached, t);
+      }
+    }
+    return files_.emplace(key, *doc).first->second;
+  }
+
+  // `section`: components section a referenced object is imported into,
+  // from the pointer if it names one, else from the position of the $ref
+  // (schemas only reference schemas, empty at the document root).
+  void resolve(YAML::Node n, fs::path const& base, std::string_view section) {
+    if (n.IsSequence()) {
+      for (auto x : n) {
+        resolve(x, base, section);
+      }
+      return;
+    }
+    if (!n.IsMap()) {
+      return;
+    }
+
+    auto const ref = static_cast<YAML::Node const&>(n)["$ref"];
+    if (ref.IsDefined() && ref.IsScalar()) {
+      auto const s = ref.as<std::string>();
+      auto const hash_pos = s.find('#');
+      auto const file = s.substr(0U, hash_pos);
+      auto const pointer =
+          hash_pos == std::string::npos ? "" : s.substr(hash_pos + 1U);
+      auto const target =
+          file.empty() ? base : (base.parent_path() / file).lexically_normal();
+      if (target != root_) {
+        auto const from_pointer = pointer_section(pointer);
+        n["$ref"] = import(target, pointer, s,
+                           !from_pointer.empty() ? from_pointer
+                           : !section.empty()    ? section
+                                                 : "schemas");
+      } else if (!file.empty()) {
+        n["$ref"] = "#" + pointer;
+      }
+    }
+
+    for (auto x : n) {
+      auto const child = section_of(x.first.Scalar());
+      resolve(x.second, base,
+              section == "schemas" || child.empty() ? section : child);
+    }
+  }
+
+  // Returns the local reference "#/components/<section>/<name>".
+  std::string import(fs::path const& p,
+                     std::string const& pointer,
+                     std::string const& ref,
+                     std::string_view const section) {
+    auto const key = fmt::format("{}:{}#{}", section, p.string(), pointer);
+    if (auto const it = imported_.find(key); it != end(imported_)) {
+      return it->second;
+    }
+
+    auto const name = pointer.empty()
+                          ? p.stem().string()
+                          : pointer.substr(pointer.rfind('/') + 1U);
+    auto const local_ref = fmt::format("#/components/{}/{}", section, name);
+    auto const components = child(files_.at(root_.string()), "components");
+    auto const taken = child(child(components, std::string{section}), name)
+                           .IsDefined();
+    utl::verify(
+        !taken &&
+            std::none_of(begin(imported_), end(imported_),
+                         [&](auto&& x) { return x.second == local_ref; }),
+        "load_spec: {} name {} of {} already taken", section, name, ref);
+    imported_.emplace(key, local_ref);
+
+    auto node = YAML::Clone(navigate(file(p), pointer, ref));
+    resolve(node, p, section);
+    components_.push_back(
+        {.section_ = std::string{section}, .name_ = name, .node_ = node});
+    return local_ref;
+  }
+
+  std::optional<fs::path> cache_dir_;
+  fs::path root_;
+  std::vector<std::pair<std::string, cista::hash_t>> deps_;
+  boost::unordered_flat_map<std::string, YAML::Node> files_;
+  boost::unordered_flat_map<std::string, std::string> imported_;
+  std::vector<component> components_;
+};
+
+}  // namespace
+
+YAML::Node to_yaml(json::value const& jv) {
+  switch (jv.kind()) {
+    case json::kind::object: {
+      auto map = YAML::Node{YAML::NodeType::Map};
+      for (auto const& [k, v] : jv.get_object()) {
+        map[std::string{k}] = to_yaml(v);
+      }
+      return map;
+    }
+
+    case json::kind::array: {
+      auto seq = YAML::Node{YAML::NodeType::Sequence};
+      for (auto const& v : jv.get_array()) {
+        seq.push_back(to_yaml(v));
+      }
+      return seq;
+    }
+
+    case json::kind::string: return YAML::Node{std::string{jv.get_string()}};
+    case json::kind::null: return YAML::Node{YAML::NodeType::Null};
+    default: return YAML::Node{json::serialize(jv)};
+  }
+}
+
+YAML::Node load_spec(fs::path const& path,
+                     std::optional<fs::path> const& cache_dir,
+                     std::vector<fs::path>* dependencies) {
+  auto const root = fs::absolute(path).lexically_normal();
+
+  auto resolved = std::optional<fs::path>{};
+  if (cache_dir.has_value()) {
+    fs::create_directories(*cache_dir);
+    auto const key = cista::hash(read_file(root), cista::hash(root.string()));
+    resolved = *cache_dir / fmt::format("{:016x}.resolved", key);
+    if (auto doc = read_tree(*resolved, dependencies); doc.has_value()) {
+      return *doc;
+    }
+  }
+
+  auto l = loader{.cache_dir_ = cache_dir, .root_ = root};
+  auto doc = YAML::Node{l.file(root)};
+  l.resolve(doc, root, "");
+  for (auto const& c : l.components_) {
+    doc["components"][c.section_][c.name_] = c.node_;
+  }
+  if (dependencies != nullptr) {
+    for (auto const& [p, hash] : l.deps_) {
+      dependencies->emplace_back(p);
+    }
+  }
+
+  if (resolved.has_value()) {
+    auto t = flatten(doc, l.deps_);
+    write_tree(*resolved, t);
+  }
+  return doc;
+}
+
+}  // namespace openapi
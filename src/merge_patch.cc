@@ -0,0 +1,46 @@
+#include "openapi/merge_patch.h"
+
+namespace openapi {
+
+json::value diff(json::value const& from, json::value const& to) {
+  if (!from.is_object() || !to.is_object()) {
+    return to;
+  }
+  auto const& a = from.get_object();
+  auto const& b = to.get_object();
+  auto patch = json::object{};
+  for (auto const& [k, v] : a) {
+    if (!b.contains(k)) {
+      patch[k] = nullptr;
+    }
+  }
+  for (auto const& [k, v] : b) {
+    auto const it = a.find(k);
+    if (it == a.end()) {
+      patch[k] = v;
+    } else if (it->value() != v) {
+      patch[k] = diff(it->value(), v);
+    }
+  }
+  return patch;
+}
+
+void apply_patch(json::value& target, json::value const& patch) {
+  if (!patch.is_object()) {
+    target = patch;
+    return;
+  }
+  if (!target.is_object()) {
+    target.emplace_object();
+  }
+  auto& o = target.get_object();
+  for (auto const& [k, v] : patch.get_object()) {
+    if (v.is_null()) {
+      o.erase(k);
+    } else {
+      apply_patch(o[k], v);
+    }
+  }
+}
+
+}  // namespace openapi
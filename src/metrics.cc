@@ -0,0 +1,175 @@
+#include "openapi/metrics.h"
+
+#include <algorithm>
+#include <bit>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <utility>
+#include <vector>
+
+namespace openapi::metrics {
+
+namespace {
+
+std::string_view to_str(stage const s) {
+  switch (s) {
+    case stage::kParams: return "params";
+    case stage::kDecode: return "decode";
+    case stage::kEncode: return "encode";
+  }
+  std::unreachable();
+}
+
+std::size_t thread_shard() {
+  static auto next = std::atomic_size_t{0U};
+  thread_local auto const shard =
+      next.fetch_add(1U, std::memory_order_relaxed) % operation::kShards;
+  return shard;
+}
+
+struct registry {
+  std::mutex mutex_;
+  std::vector<std::unique_ptr<operation>> operations_;
+};
+
+registry& get_registry() {
+  static auto r = registry{};
+  return r;
+}
+
+template <typename Fn>
+std::uint64_t sum(operation const& op, stage const s, Fn&& fn) {
+  auto total = std::uint64_t{0U};
+  for (auto const& shards : op.shards_) {
+    total += fn(shards[static_cast<std::size_t>(s)]);
+  }
+  return total;
+}
+
+}  // namespace
+
+std::size_t bucket(std::uint64_t const ns) {
+  if (ns < kSubBuckets) {
+    return static_cast<std::size_t>(ns);
+  }
+  auto const msb = static_cast<unsigned>(std::bit_width(ns)) - 1U;
+  if (msb > kMaxMsb) {
+    return kBuckets - 1U;
+  }
+  auto const sub = (ns >> (msb - kSubBucketBits)) & (kSubBuckets - 1U);
+  return (msb - 1U) * kSubBuckets + sub;
+}
+
+std::uint64_t bucket_limit(std::size_t const i) {
+  if (i < kSubBuckets) {
+    return i + 1U;
+  }
+  auto const msb = i / kSubBuckets + 1U;
+  auto const sub = i % kSubBuckets;
+  return (kSubBuckets + sub + 1U) << (msb - kSubBucketBits);
+}
+
+operation::operation(std::string_view id) : id_{id} {}
+
+void operation::record(stage const s,
+                       std::chrono::nanoseconds const duration,
+                       std::size_t const bytes,
+                       bool const error) noexcept {
+  auto& x = shards_[thread_shard()][static_cast<std::size_t>(s)];
+  auto const ns = duration.count() < 0
+                      ? std::uint64_t{0U}
+                      : static_cast<std::uint64_t>(duration.count());
+  x.buckets_[bucket(ns)].fetch_add(1U, std::memory_order_relaxed);
+  x.count_.fetch_add(1U, std::memory_order_relaxed);
+  x.sum_ns_.fetch_add(ns, std::memory_order_relaxed);
+  x.bytes_.fetch_add(bytes, std::memory_order_relaxed);
+  if (error) {
+    x.errors_.fetch_add(1U, std::memory_order_relaxed);
+  }
+}
+
+std::uint64_t operation::count(stage const s) const {
+  return sum(*this, s, [](shard const& x) { return x.count_.load(); });
+}
+
+std::uint64_t operation::bytes(stage const s) const {
+  return sum(*this, s, [](shard const& x) { return x.bytes_.load(); });
+}
+
+std::uint64_t operation::errors(stage const s) const {
+  return sum(*this, s, [](shard const& x) { return x.errors_.load(); });
+}
+
+operation& get(std::string_view operation_id) {
+  auto& r = get_registry();
+  auto const lock = std::scoped_lock{r.mutex_};
+  auto const it = std::ranges::find_if(
+      r.operations_, [&](auto const& op) { return op->id_ == operation_id; });
+  if (it != end(r.operations_)) {
+    return **it;
+  }
+  return *r.operations_.emplace_back(std::make_unique<operation>(operation_id));
+}
+
+void write_prometheus(std::ostream& out) {
+  auto& r = get_registry();
+  auto const lock = std::scoped_lock{r.mutex_};
+
+  auto const for_each_stage = [&](auto&& fn) {
+    for (auto const& op : r.operations_) {
+      for (auto s = 0U; s != kStages; ++s) {
+        if (op->count(stage{static_cast<std::uint8_t>(s)}) != 0U) {
+          fn(*op, stage{static_cast<std::uint8_t>(s)});
+        }
+      }
+    }
+  };
+
+  auto const labels = [](operation const& op, stage const s) {
+    return "operation=\"" + op.id_ + "\",stage=\"" +
+           std::string{to_str(s)} + "\"";
+  };
+
+  out << "# HELP openapi_latency_seconds Latency of generated codecs.\n"
+      << "# TYPE openapi_latency_seconds histogram\n";
+  for_each_stage([&](operation const& op, stage const s) {
+    auto const l = labels(op, s);
+    auto cumulative = std::uint64_t{0U};
+    for (auto i = std::size_t{0U}; i != kBuckets; ++i) {
+      cumulative += sum(op, s, [&](shard const& x) {
+        return x.buckets_[i].load(std::memory_order_relaxed);
+      });
+      // Export one boundary per power of two to keep the output small.
+      if (i % kSubBuckets == kSubBuckets - 1U && i != kBuckets - 1U) {
+        out << "openapi_latency_seconds_bucket{" << l << ",le=\""
+            << static_cast<double>(bucket_limit(i)) / 1e9 << "\"} "
+            << cumulative << "\n";
+      }
+    }
+    out << "openapi_latency_seconds_bucket{" << l << ",le=\"+Inf\"} "
+        << cumulative << "\n";
+    auto const sum_ns =
+        sum(op, s, [](shard const& x) { return x.sum_ns_.load(); });
+    out << "openapi_latency_seconds_sum{" << l << "} "
+        << static_cast<double>(sum_ns) / 1e9 << "\n";
+    out << "openapi_latency_seconds_count{" << l << "} " << op.count(s)
+        << "\n";
+  });
+
+  out << "# HELP openapi_bytes_total Payload bytes of generated codecs.\n"
+      << "# TYPE openapi_bytes_total counter\n";
+  for_each_stage([&](operation const& op, stage const s) {
+    out << "openapi_bytes_total{" << labels(op, s) << "} " << op.bytes(s)
+        << "\n";
+  });
+
+  out << "# HELP openapi_errors_total Failed calls of generated codecs.\n"
+      << "# TYPE openapi_errors_total counter\n";
+  for_each_stage([&](operation const& op, stage const s) {
+    out << "openapi_errors_total{" << labels(op, s) << "} " << op.errors(s)
+        << "\n";
+  });
+}
+
+}  // namespace openapi::metrics
@@ -0,0 +1,565 @@
+#include "openapi/msgpack.h"
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cstdlib>
+#include <cstring>
+#include <limits>
+#include <optional>
+
+#include "boost/json.hpp"
+
+#include "utl/verify.h"
+
+namespace json = boost::json;
+
+namespace openapi {
+
+namespace {
+
+template <typename T>
+void append(std::string& out, T const x) {
+  auto const be = std::bit_cast<std::array<char, sizeof(T)>>(
+      std::endian::native == std::endian::little ? std::byteswap(x) : x);
+  out.append(be.data(), be.size());
+}
+
+template <typename T>
+void put(std::string& out, std::uint8_t const tag, T const x) {
+  out.push_back(static_cast<char>(tag));
+  append(out, x);
+}
+
+constexpr auto const kTimestampType = std::uint8_t{0xffU};  // -1
+
+void put_size(std::string& out,
+              std::size_t const size,
+              std::uint8_t const fix,
+              std::size_t const fix_max,
+              std::uint8_t const tag16) {
+  if (size <= fix_max) {
+    out.push_back(static_cast<char>(fix | size));
+  } else if (size <= std::numeric_limits<std::uint16_t>::max()) {
+    put(out, tag16, static_cast<std::uint16_t>(size));
+  } else {
+    utl::verify(size <= std::numeric_limits<std::uint32_t>::max(),
+                "msgpack: size {} too large", size);
+    put(out, static_cast<std::uint8_t>(tag16 + 1U),
+        static_cast<std::uint32_t>(size));
+  }
+}
+
+}  // namespace
+
+void msgpack_writer::write_nil() { out_.push_back('\xc0'); }
+
+void msgpack_writer::write_bool(bool const b) {
+  out_.push_back(b ? '\xc3' : '\xc2');
+}
+
+void msgpack_writer::write_int(std::int64_t const i) {
+  if (i >= 0) {
+    write_uint(static_cast<std::uint64_t>(i));
+  } else if (i >= -32) {
+    out_.push_back(static_cast<char>(i));
+  } else if (i >= std::numeric_limits<std::int8_t>::min()) {
+    put(out_, 0xd0U, static_cast<std::int8_t>(i));
+  } else if (i >= std::numeric_limits<std::int16_t>::min()) {
+    put(out_, 0xd1U, static_cast<std::int16_t>(i));
+  } else if (i >= std::numeric_limits<std::int32_t>::min()) {
+    put(out_, 0xd2U, static_cast<std::int32_t>(i));
+  } else {
+    put(out_, 0xd3U, i);
+  }
+}
+
+void msgpack_writer::write_uint(std::uint64_t const i) {
+  if (i <= 0x7FU) {
+    out_.push_back(static_cast<char>(i));
+  } else if (i <= std::numeric_limits<std::uint8_t>::max()) {
+    put(out_, 0xccU, static_cast<std::uint8_t>(i));
+  } else if (i <= std::numeric_limits<std::uint16_t>::max()) {
+    put(out_, 0xcdU, static_cast<std::uint16_t>(i));
+  } else if (i <= std::numeric_limits<std::uint32_t>::max()) {
+    put(out_, 0xceU, static_cast<std::uint32_t>(i));
+  } else {
+    put(out_, 0xcfU, i);
+  }
+}
+
+void msgpack_writer::write_float(float const f) {
+  put(out_, 0xcaU, std::bit_cast<std::uint32_t>(f));
+}
+
+void msgpack_writer::write_double(double const d) {
+  put(out_, 0xcbU, std::bit_cast<std::uint64_t>(d));
+}
+
+void msgpack_writer::write_string(std::string_view const s) {
+  if (s.size() < 32U) {
+    out_.push_back(static_cast<char>(0xa0U | s.size()));
+  } else if (s.size() <= std::numeric_limits<std::uint8_t>::max()) {
+    put(out_, 0xd9U, static_cast<std::uint8_t>(s.size()));
+  } else {
+    put_size(out_, s.size(), 0xa0U, 31U, 0xdaU);
+  }
+  out_.append(s);
+}
+
+// Smallest of timestamp 32 / 64 / 96.
+void msgpack_writer::write_timestamp(msgpack_timestamp const t) {
+  if (t.seconds_ >= 0 && (t.seconds_ >> 34) == 0) {
+    auto const x = (std::uint64_t{t.nanoseconds_} << 34U) |
+                   static_cast<std::uint64_t>(t.seconds_);
+    if ((x >> 32U) == 0U) {
+      out_.push_back('\xd6');
+      put(out_, kTimestampType, static_cast<std::uint32_t>(x));
+    } else {
+      out_.push_back('\xd7');
+      put(out_, kTimestampType, x);
+    }
+  } else {
+    out_.append("\xc7\x0c");
+    put(out_, kTimestampType, t.nanoseconds_);
+    append(out_, t.seconds_);
+  }
+}
+
+void msgpack_writer::write_array(std::size_t const size) {
+  put_size(out_, size, 0x90U, 15U, 0xdcU);
+}
+
+void msgpack_writer::write_map(std::size_t const size) {
+  put_size(out_, size, 0x80U, 15U, 0xdeU);
+}
+
+void msgpack_writer::write_key(std::uint32_t const index,
+                               std::string_view name) {
+  if (keys_ == msgpack_keys::kIndices) {
+    write_uint(index);
+  } else {
+    write_string(name);
+  }
+}
+
+namespace {
+
+struct cursor {
+  std::uint8_t peek() const {
+    utl::verify(r_.pos_ < r_.in_.size(), "msgpack: unexpected end");
+    return static_cast<std::uint8_t>(r_.in_[r_.pos_]);
+  }
+
+  template <typename T>
+  T get() {
+    utl::verify(r_.in_.size() - r_.pos_ >= sizeof(T),
+                "msgpack: unexpected end");
+    auto be = std::array<char, sizeof(T)>{};
+    std::memcpy(be.data(), r_.in_.data() + r_.pos_, sizeof(T));
+    r_.pos_ += sizeof(T);
+    auto const x = std::bit_cast<T>(be);
+    return std::endian::native == std::endian::little ? std::byteswap(x) : x;
+  }
+
+  std::string_view bytes(std::size_t const n) {
+    utl::verify(r_.in_.size() - r_.pos_ >= n, "msgpack: unexpected end");
+    auto const s = r_.in_.substr(r_.pos_, n);
+    r_.pos_ += n;
+    return s;
+  }
+
+  [[noreturn]] void fail(std::string_view expected) const {
+    throw utl::fail("msgpack: expected {} at offset {}, got 0x{:02x}",
+                    expected, r_.pos_, peek());
+  }
+
+  msgpack_reader& r_;
+};
+
+// Length of a string / array / map header, nullopt if `tag` is none.
+std::optional<std::uint32_t> get_size(cursor& c,
+                                      std::uint8_t const fix,
+                                      std::uint8_t const fix_mask,
+                                      std::uint8_t const tag8,
+                                      std::uint8_t const tag16) {
+  auto const tag = c.peek();
+  if ((tag & static_cast<std::uint8_t>(~fix_mask)) == fix) {
+    ++c.r_.pos_;
+    return tag & fix_mask;
+  } else if (tag8 != 0U && tag == tag8) {
+    ++c.r_.pos_;
+    return c.get<std::uint8_t>();
+  } else if (tag == tag16) {
+    ++c.r_.pos_;
+    return c.get<std::uint16_t>();
+  } else if (tag == tag16 + 1U) {
+    ++c.r_.pos_;
+    return c.get<std::uint32_t>();
+  }
+  return std::nullopt;
+}
+
+}  // namespace
+
+bool msgpack_reader::is_nil() const {
+  return pos_ < in_.size() && in_[pos_] == '\xc0';
+}
+
+bool msgpack_reader::is_string() const {
+  if (pos_ == in_.size()) {
+    return false;
+  }
+  auto const tag = static_cast<std::uint8_t>(in_[pos_]);
+  return (tag & 0xe0U) == 0xa0U || (tag >= 0xd9U && tag <= 0xdbU);
+}
+
+void msgpack_reader::read_nil() {
+  auto c = cursor{*this};
+  if (c.peek() != 0xc0U) {
+    c.fail("nil");
+  }
+  ++pos_;
+}
+
+bool msgpack_reader::read_bool() {
+  auto c = cursor{*this};
+  switch (c.peek()) {
+    case 0xc2U: ++pos_; return false;
+    case 0xc3U: ++pos_; return true;
+    default: c.fail("bool");
+  }
+}
+
+std::int64_t msgpack_reader::read_int() {
+  auto c = cursor{*this};
+  auto const tag = c.peek();
+  if (tag <= 0x7FU || tag >= 0xe0U) {
+    ++pos_;
+    return static_cast<std::int8_t>(tag);
+  }
+  switch (tag) {
+    case 0xd0U: ++pos_; return c.get<std::int8_t>();
+    case 0xd1U: ++pos_; return c.get<std::int16_t>();
+    case 0xd2U: ++pos_; return c.get<std::int32_t>();
+    case 0xd3U: ++pos_; return c.get<std::int64_t>();
+    case 0xccU:
+    case 0xcdU:
+    case 0xceU:
+    case 0xcfU: {
+      auto const u = read_uint();
+      utl::verify(std::in_range<std::int64_t>(u), "msgpack: {} out of range",
+                  u);
+      return static_cast<std::int64_t>(u);
+    }
+    default: c.fail("integer");
+  }
+}
+
+std::uint64_t msgpack_reader::read_uint() {
+  auto c = cursor{*this};
+  auto const tag = c.peek();
+  if (tag <= 0x7FU) {
+    ++pos_;
+    return tag;
+  }
+  switch (tag) {
+    case 0xccU: ++pos_; return c.get<std::uint8_t>();
+    case 0xcdU: ++pos_; return c.get<std::uint16_t>();
+    case 0xceU: ++pos_; return c.get<std::uint32_t>();
+    case 0xcfU: ++pos_; return c.get<std::uint64_t>();
+    default: c.fail("unsigned integer");
+  }
+}
+
+double msgpack_reader::read_double() {
+  auto c = cursor{*this};
+  switch (c.peek()) {
+    case 0xcaU:
+      ++pos_;
+      return std::bit_cast<float>(c.get<std::uint32_t>());
+    case 0xcbU: ++pos_; return std::bit_cast<double>(c.get<std::uint64_t>());
+    case 0xccU:
+    case 0xcdU:
+    case 0xceU:
+    case 0xcfU: return static_cast<double>(read_uint());
+    default: return static_cast<double>(read_int());
+  }
+}
+
+std::string_view msgpack_reader::read_string() {
+  auto c = cursor{*this};
+  auto const size = get_size(c, 0xa0U, 0x1fU, 0xd9U, 0xdaU);
+  if (!size.has_value()) {
+    c.fail("string");
+  }
+  return c.bytes(*size);
+}
+
+msgpack_timestamp msgpack_reader::read_timestamp() {
+  auto c = cursor{*this};
+  auto const type = [&]() {
+    utl::verify(c.get<std::uint8_t>() == kTimestampType,
+                "msgpack: expected timestamp extension at offset {}", pos_);
+  };
+  auto t = msgpack_timestamp{};
+  switch (c.peek()) {
+    case 0xd6U:
+      ++pos_;
+      type();
+      t = {c.get<std::uint32_t>(), 0U};
+      break;
+    case 0xd7U: {
+      ++pos_;
+      type();
+      auto const x = c.get<std::uint64_t>();
+      t = {static_cast<std::int64_t>(x & ((std::uint64_t{1U} << 34U) - 1U)),
+           static_cast<std::uint32_t>(x >> 34U)};
+    } break;
+    case 0xc7U:
+      ++pos_;
+      utl::verify(c.get<std::uint8_t>() == 12U,
+                  "msgpack: timestamp 96 expects 12 bytes");
+      type();
+      t.nanoseconds_ = c.get<std::uint32_t>();
+      t.seconds_ = c.get<std::int64_t>();
+      break;
+    default: c.fail("timestamp");
+  }
+  utl::verify(t.nanoseconds_ < 1'000'000'000U,
+              "msgpack: timestamp nanoseconds {} out of range",
+              t.nanoseconds_);
+  return t;
+}
+
+std::uint32_t msgpack_reader::read_array() {
+  auto c = cursor{*this};
+  auto const size = get_size(c, 0x90U, 0x0fU, 0U, 0xdcU);
+  if (!size.has_value()) {
+    c.fail("array");
+  }
+  utl::verify(*size <= in_.size() - pos_,
+              "msgpack: array of {} elements exceeds the remaining {} bytes",
+              *size, in_.size() - pos_);
+  return *size;
+}
+
+std::uint32_t msgpack_reader::read_map() {
+  auto c = cursor{*this};
+  auto const size = get_size(c, 0x80U, 0x0fU, 0U, 0xdeU);
+  if (!size.has_value()) {
+    c.fail("map");
+  }
+  utl::verify(2U * std::size_t{*size} <= in_.size() - pos_,
+              "msgpack: map of {} entries exceeds the remaining {} bytes",
+              *size, in_.size() - pos_);
+  return *size;
+}
+
+std::uint32_t msgpack_reader::read_key(
+    std::span<std::string_view const> names) {
+  auto const n = static_cast<std::uint32_t>(names.size());
+  unknown_key_.reset();
+  if (!is_string()) {
+    return static_cast<std::uint32_t>(std::min(read_uint(), std::uint64_t{n}));
+  }
+  auto const key = read_string();
+  auto const it = std::ranges::find(names, key);
+  if (it == end(names)) {
+    unknown_key_ = key;
+  }
+  return static_cast<std::uint32_t>(it - begin(names));
+}
+
+void msgpack_reader::skip() {
+  auto c = cursor{*this};
+  auto const tag = c.peek();
+  auto const skip_n = [&](std::size_t const n) {
+    for (auto i = std::size_t{0U}; i != n; ++i) {
+      skip();
+    }
+  };
+  if (tag <= 0x7FU || tag >= 0xe0U || (tag >= 0xc0U && tag <= 0xc3U)) {
+    ++pos_;
+  } else if ((tag & 0xe0U) == 0xa0U || (tag >= 0xd9U && tag <= 0xdbU)) {
+    read_string();
+  } else if ((tag & 0xf0U) == 0x90U || tag == 0xdcU || tag == 0xddU) {
+    skip_n(read_array());
+  } else if ((tag & 0xf0U) == 0x80U || tag == 0xdeU || tag == 0xdfU) {
+    skip_n(2U * std::size_t{read_map()});
+  } else {
+    ++pos_;
+    switch (tag) {
+      case 0xc4U: c.bytes(c.get<std::uint8_t>()); break;  // bin
+      case 0xc5U: c.bytes(c.get<std::uint16_t>()); break;
+      case 0xc6U: c.bytes(c.get<std::uint32_t>()); break;
+      case 0xc7U: c.bytes(1U + c.get<std::uint8_t>()); break;  // ext
+      case 0xc8U: c.bytes(1U + c.get<std::uint16_t>()); break;
+      case 0xc9U: c.bytes(1U + std::size_t{c.get<std::uint32_t>()}); break;
+      case 0xcaU: c.bytes(4U); break;
+      case 0xcbU: c.bytes(8U); break;
+      case 0xccU:
+      case 0xd0U: c.bytes(1U); break;
+      case 0xcdU:
+      case 0xd1U: c.bytes(2U); break;
+      case 0xceU:
+      case 0xd2U: c.bytes(4U); break;
+      case 0xcfU:
+      case 0xd3U: c.bytes(8U); break;
+      case 0xd4U: c.bytes(2U); break;  // fixext
+      case 0xd5U: c.bytes(3U); break;
+      case 0xd6U: c.bytes(5U); break;
+      case 0xd7U: c.bytes(9U); break;
+      case 0xd8U: c.bytes(17U); break;
+      default: --pos_; c.fail("value");
+    }
+  }
+}
+
+void msgpack_write(msgpack_writer& w, json::value const& jv) {
+  switch (jv.kind()) {
+    case json::kind::null: w.write_nil(); break;
+    case json::kind::bool_: w.write_bool(jv.get_bool()); break;
+    case json::kind::int64: w.write_int(jv.get_int64()); break;
+    case json::kind::uint64: w.write_uint(jv.get_uint64()); break;
+    case json::kind::double_: w.write_double(jv.get_double()); break;
+    case json::kind::string: w.write_string(jv.get_string()); break;
+    case json::kind::array:
+      w.write_array(jv.get_array().size());
+      for (auto const& x : jv.get_array()) {
+        msgpack_write(w, x);
+      }
+      break;
+    case json::kind::object:
+      w.write_map(jv.get_object().size());
+      for (auto const& [k, v] : jv.get_object()) {
+        w.write_string(k);
+        msgpack_write(w, v);
+      }
+      break;
+  }
+}
+
+void msgpack_read(msgpack_reader& r, json::value& jv) {
+  auto const tag = static_cast<std::uint8_t>(cursor{r}.peek());
+  if (r.is_nil()) {
+    r.read_nil();
+    jv = nullptr;
+  } else if (tag == 0xc2U || tag == 0xc3U) {
+    jv = r.read_bool();
+  } else if (r.is_string()) {
+    jv = r.read_string();
+  } else if (tag == 0xcaU || tag == 0xcbU) {
+    jv = r.read_double();
+  } else if (tag == 0xcfU) {
+    jv = r.read_uint();
+  } else if ((tag & 0xf0U) == 0x90U || tag == 0xdcU || tag == 0xddU) {
+    auto& arr = jv.emplace_array();
+    arr.resize(r.read_array());
+    for (auto& x : arr) {
+      msgpack_read(r, x);
+    }
+  } else if ((tag & 0xf0U) == 0x80U || tag == 0xdeU || tag == 0xdfU) {
+    auto& o = jv.emplace_object();
+    auto const n = r.read_map();
+    o.reserve(n);
+    for (auto i = 0U; i != n; ++i) {
+      msgpack_read(r, o[r.read_string()]);
+    }
+  } else {
+    jv = r.read_int();
+  }
+}
+
+namespace {
+
+// Media range without parameters and its q-value.
+std::pair<std::string_view, float> parse_media_range(std::string_view s) {
+  auto const trim = [](std::string_view x) {
+    auto const first = x.find_first_not_of(" \t");
+    if (first == std::string_view::npos) {
+      return std::string_view{};
+    }
+    return x.substr(first, x.find_last_not_of(" \t") - first + 1U);
+  };
+
+  auto const semicolon = s.find(';');
+  auto const type = trim(s.substr(0U, semicolon));
+  auto q = 1.0F;
+  auto params = semicolon == std::string_view::npos
+                    ? std::string_view{}
+                    : s.substr(semicolon + 1U);
+  while (!params.empty()) {
+    auto const end = params.find(';');
+    auto const param = trim(params.substr(0U, end));
+    if (param.starts_with("q=") || param.starts_with("Q=")) {
+      q = std::strtof(std::string{param.substr(2U)}.c_str(), nullptr);
+    }
+    params = end == std::string_view::npos ? std::string_view{}
+                                           : params.substr(end + 1U);
+  }
+  return {type, q};
+}
+
+bool is_msgpack(std::string_view const type) {
+  return type == "application/msgpack" || type == "application/x-msgpack" ||
+         type == "application/vnd.msgpack";
+}
+
+}  // namespace
+
+wire_format negotiate(std::string_view accept) {
+  struct match {
+    float q_{0.0F};
+    int specificity_{-1};
+  };
+  auto json_match = match{};
+  auto msgpack_match = match{};
+  auto const update = [](match& m, float const q, int const specificity) {
+    if (specificity > m.specificity_) {
+      m = {q, specificity};
+    }
+  };
+
+  while (!accept.empty()) {
+    auto const end = accept.find(',');
+    auto const [type, q] = parse_media_range(accept.substr(0U, end));
+    if (type == "*/*" || type == "application/*") {
+      auto const specificity = type == "*/*" ? 0 : 1;
+      update(json_match, q, specificity);
+      update(msgpack_match, q, specificity);
+    } else if (type == "application/json") {
+      update(json_match, q, 2);
+    } else if (is_msgpack(type)) {
+      update(msgpack_match, q, 2);
+    }
+    accept = end == std::string_view::npos ? std::string_view{}
+                                           : accept.substr(end + 1U);
+  }
+
+  auto const prefer_msgpack =
+      msgpack_match.q_ > json_match.q_ ||
+      (msgpack_match.q_ > 0.0F && msgpack_match.q_ == json_match.q_ &&
+       msgpack_match.specificity_ > json_match.specificity_);
+  return prefer_msgpack ? wire_format::kMsgpack : wire_format::kJson;
+}
+
+std::optional<wire_format> from_content_type(std::string_view s) {
+  auto const type = parse_media_range(s).first;
+  if (type.empty() || type == "application/json") {
+    return wire_format::kJson;
+  } else if (is_msgpack(type)) {
+    return wire_format::kMsgpack;
+  }
+  return std::nullopt;
+}
+
+std::string_view content_type(wire_format const f) {
+  switch (f) {
+    case wire_format::kJson: return "application/json";
+    case wire_format::kMsgpack: return "application/msgpack";
+  }
+  throw utl::fail("invalid wire_format {}", static_cast<int>(f));
+}
+
+}  // namespace openapi
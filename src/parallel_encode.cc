@@ -0,0 +1,103 @@
+#include "openapi/parallel_encode.h"
+
+#include <utility>
+
+namespace openapi {
+
+encode_pool::encode_pool(unsigned const n_threads) {
+  auto const n_workers = std::max(n_threads, 1U) - 1U;
+  workers_.reserve(n_workers);
+  for (auto i = 0U; i != n_workers; ++i) {
+    workers_.emplace_back([this] { worker(); });
+  }
+}
+
+encode_pool::~encode_pool() {
+  {
+    auto const lock = std::lock_guard{mutex_};
+    stop_ = true;
+  }
+  start_.notify_all();
+  for (auto& w : workers_) {
+    w.join();
+  }
+}
+
+void encode_pool::run(std::size_t const n,
+                      std::function<void(std::size_t)> const& fn) {
+  if (busy_.exchange(true, std::memory_order_acquire)) {
+    for (auto i = std::size_t{0U}; i != n; ++i) {
+      fn(i);
+    }
+    return;
+  }
+
+  {
+    auto const lock = std::lock_guard{mutex_};
+    fn_ = &fn;
+    n_ = n;
+    next_ = 0U;
+    ++generation_;
+    ++active_;
+  }
+  start_.notify_all();
+
+  work(fn, n);
+
+  auto lock = std::unique_lock{mutex_};
+  --active_;
+  done_.wait(lock, [&] { return active_ == 0U; });
+  fn_ = nullptr;  // workers waking up late must not pick up this job
+  auto const error = std::exchange(error_, nullptr);
+  busy_.store(false, std::memory_order_release);
+  if (error != nullptr) {
+    std::rethrow_exception(error);
+  }
+}
+
+void encode_pool::worker() {
+  auto seen = std::size_t{0U};
+  auto lock = std::unique_lock{mutex_};
+  while (true) {
+    start_.wait(lock, [&] { return stop_ || generation_ != seen; });
+    if (stop_) {
+      return;
+    }
+    seen = generation_;
+    if (fn_ == nullptr) {
+      continue;
+    }
+
+    auto const& fn = *fn_;
+    auto const n = n_;
+    ++active_;
+    lock.unlock();
+    work(fn, n);
+    lock.lock();
+    if (--active_ == 0U) {
+      done_.notify_all();
+    }
+  }
+}
+
+void encode_pool::work(std::function<void(std::size_t)> const& fn,
+                       std::size_t const n) {
+  for (auto i = next_.fetch_add(1U); i < n; i = next_.fetch_add(1U)) {
+    try {
+      fn(i);
+    } catch (...) {
+      auto const lock = std::lock_guard{mutex_};
+      if (error_ == nullptr) {
+        error_ = std::current_exception();
+      }
+      next_ = n;
+    }
+  }
+}
+
+encode_pool& default_encode_pool() {
+  static auto pool = encode_pool{};
+  return pool;
+}
+
+}  // namespace openapi
@@ -0,0 +1,906 @@
+#include "openapi/schema_vm.h"
+
+#include <algorithm>
+#include <cmath>
+#include <deque>
+#include <exception>
+#include <iterator>
+#include <memory>
+#include <span>
+#include <utility>
+
+#include "boost/json/basic_parser_impl.hpp"
+#include "boost/unordered/unordered_flat_map.hpp"
+
+#include "fmt/format.h"
+#include "fmt/ranges.h"
+
+#include "cista/hash.h"
+
+#include "utl/verify.h"
+
+#include "openapi/date_time.h"
+#include "openapi/gen_types.h"
+
+namespace json = boost::json;
+
+namespace openapi {
+
+namespace {
+
+// Marks object properties unknown to the schema (dropped by filter).
+constexpr auto const kUnknown = kNoTarget - 1U;
+
+number_format to_format(std::string_view const cpp_type) {
+  switch (cista::hash(cpp_type)) {
+    case cista::hash("std::int8_t"): return number_format::kInt8;
+    case cista::hash("std::int16_t"): return number_format::kInt16;
+    case cista::hash("std::int32_t"): return number_format::kInt32;
+    case cista::hash("std::uint8_t"): return number_format::kUInt8;
+    case cista::hash("std::uint16_t"): return number_format::kUInt16;
+    case cista::hash("std::uint32_t"): return number_format::kUInt32;
+    case cista::hash("std::uint64_t"): return number_format::kUInt64;
+    case cista::hash("float"): return number_format::kFloat;
+    case cista::hash("double"): return number_format::kDouble;
+    default: return number_format::kInt64;
+  }
+}
+
+struct compiler {
+  std::uint32_t compile(YAML::Node const& schema) {
+    auto const ref = schema["$ref"];
+    if (ref.IsDefined()) {
+      auto const name = std::string{ref_name(ref)};
+      if (auto const it = refs_.find(name); it != end(refs_)) {
+        return it->second;
+      }
+
+      // Reserve the slot first: the schema may refer to itself.
+      auto const pc = static_cast<std::uint32_t>(p_.code_.size());
+      p_.code_.emplace_back();
+      refs_.emplace(name, pc);
+
+      auto const target = resolve_schema(root_, schema);
+      utl::verify(target.IsDefined(), "schema {} not found", name);
+      auto const i = body(target);
+      p_.code_[pc] = i;
+      return pc;
+    }
+
+    auto const i = body(schema);
+    p_.code_.push_back(i);
+    return static_cast<std::uint32_t>(p_.code_.size() - 1U);
+  }
+
+  instruction body(YAML::Node const& schema) {
+    if (!has_type(schema)) {
+      return {.op_ = opcode::kAny};
+    }
+
+    switch (auto const t = to_type(schema); t) {
+      case type::kBoolean: return {.op_ = opcode::kBoolean};
+
+      case type::kInteger:
+      case type::kNumber:
+        return {.op_ = t == type::kInteger ? opcode::kInteger : opcode::kNumber,
+                .format_ = to_format(get_number_type(schema))};
+
+      case type::kString:
+        return schema["enum"].IsDefined() ? enumeration(schema)
+                                          : instruction{.op_ = opcode::kString};
+
+      case type::kDate: return {.op_ = opcode::kDate};
+
+      case type::kArray: {
+        auto const items = schema["items"];
+        return {.op_ = opcode::kArray,
+                .target_ = items.IsDefined() ? compile(items) : kNoTarget};
+      }
+
+      case type::kObject:
+        if (is_map(schema)) {
+          auto const additional = schema["additionalProperties"];
+          return {.op_ = opcode::kMap,
+                  .target_ = additional.IsDefined() && additional.IsMap()
+                                 ? compile(additional)
+                                 : kNoTarget};
+        }
+        return object(schema["allOf"].IsDefined()
+                          ? flatten_all_of(root_, schema)
+                          : schema);
+
+      case type::kVariant: return variant(schema);
+    }
+    std::unreachable();
+  }
+
+  instruction enumeration(YAML::Node const& schema) {
+    auto values = std::vector<std::string>{};
+    for (auto const& v : schema["enum"]) {
+      values.push_back(v.as<std::string>());
+    }
+    std::ranges::sort(values);
+
+    auto const begin = static_cast<std::uint32_t>(p_.strings_.size());
+    for (auto& v : values) {
+      p_.strings_.push_back(std::move(v));
+    }
+    return {.op_ = opcode::kEnum,
+            .begin_ = begin,
+            .end_ = static_cast<std::uint32_t>(p_.strings_.size())};
+  }
+
+  instruction object(YAML::Node const& schema) {
+    auto const required = schema["required"];
+    auto const is_required = [&](std::string_view name) {
+      for (auto const& x : required) {
+        if (x.as<std::string_view>() == name) {
+          return true;
+        }
+      }
+      return false;
+    };
+
+    struct entry {
+      std::string name_;
+      std::uint32_t pc_;
+      bool required_;
+    };
+    auto entries = std::vector<entry>{};
+    for (auto const& p : schema["properties"]) {
+      auto name = p.first.as<std::string>();
+      auto const pc = compile(p.second);
+      entries.push_back({std::move(name), pc, is_required(p.first.Scalar())});
+    }
+    std::ranges::sort(entries, {}, &entry::name_);
+
+    auto const begin = static_cast<std::uint32_t>(p_.properties_.size());
+    auto bit = std::uint8_t{0U};
+    for (auto const& e : entries) {
+      utl::verify(!e.required_ || bit < 64U,
+                  "schema vm: more than 64 required properties");
+      p_.properties_.push_back(
+          {.name_ = add_string(e.name_),
+           .pc_ = e.pc_,
+           .required_bit_ = e.required_ ? bit++ : schema_property::kOptional});
+    }
+    return {.op_ = opcode::kObject,
+            .begin_ = begin,
+            .end_ = static_cast<std::uint32_t>(p_.properties_.size())};
+  }
+
+  // Discriminator values as in gen_variant: mapping first, then the names
+  // of the referenced schemas.
+  instruction variant(YAML::Node const& schema) {
+    auto const alternatives = get_alternatives(schema);
+    auto pcs = std::vector<std::uint32_t>{};
+    for (auto const& a : alternatives) {
+      pcs.push_back(compile(a));
+    }
+
+    auto v = variant_info{};
+    auto tags = std::vector<std::pair<std::string, std::uint32_t>>{};
+    auto const discriminator = schema["discriminator"];
+    if (discriminator.IsDefined()) {
+      v.discriminator_ =
+          add_string(discriminator["propertyName"].as<std::string>());
+      auto const pc_of = [&](std::string_view ref) {
+        for (auto i = 0U; i != alternatives.size(); ++i) {
+          auto const r = alternatives[i]["$ref"];
+          if (r.IsDefined() && r.as<std::string_view>() == ref) {
+            return pcs[i];
+          }
+        }
+        throw utl::fail("discriminator mapping {} is not an alternative", ref);
+      };
+      for (auto const& m : discriminator["mapping"]) {
+        tags.emplace_back(m.first.as<std::string>(),
+                          pc_of(m.second.as<std::string_view>()));
+      }
+      for (auto const& a : alternatives) {
+        auto const ref = a["$ref"];
+        utl::verify(ref.IsDefined(), "discriminated alternatives need $ref");
+        auto const value = std::string{ref_name(ref)};
+        if (std::ranges::none_of(tags,
+                                 [&](auto&& t) { return t.first == value; })) {
+          tags.emplace_back(value, pc_of(ref.as<std::string_view>()));
+        }
+      }
+    }
+
+    v.alternatives_begin_ = static_cast<std::uint32_t>(p_.alternatives_.size());
+    p_.alternatives_.insert(end(p_.alternatives_), begin(pcs), end(pcs));
+    v.alternatives_end_ = static_cast<std::uint32_t>(p_.alternatives_.size());
+
+    v.tags_begin_ = static_cast<std::uint32_t>(p_.tags_.size());
+    for (auto const& [value, pc] : tags) {
+      p_.tags_.push_back({.value_ = add_string(value), .pc_ = pc});
+    }
+    v.tags_end_ = static_cast<std::uint32_t>(p_.tags_.size());
+
+    p_.variants_.push_back(v);
+    return {.op_ = opcode::kVariant,
+            .target_ = static_cast<std::uint32_t>(p_.variants_.size() - 1U)};
+  }
+
+  std::uint32_t add_string(std::string s) {
+    p_.strings_.push_back(std::move(s));
+    return static_cast<std::uint32_t>(p_.strings_.size() - 1U);
+  }
+
+  YAML::Node const& root_;
+  schema_program& p_;
+  boost::unordered_flat_map<std::string, std::uint32_t> refs_;
+};
+
+// ---------------------------------------------------------------------------
+
+enum class mode : std::uint8_t { kValidate, kFilter, kNormalize };
+
+enum class token_kind : std::uint8_t {
+  kObjectBegin,
+  kObjectEnd,
+  kArrayBegin,
+  kArrayEnd,
+  kKey,
+  kString,
+  kInt64,
+  kUInt64,
+  kDouble,
+  kBool,
+  kNull
+};
+
+struct token {
+  bool is_begin() const {
+    return kind_ == token_kind::kObjectBegin ||
+           kind_ == token_kind::kArrayBegin;
+  }
+
+  bool is_end() const {
+    return kind_ == token_kind::kObjectEnd || kind_ == token_kind::kArrayEnd;
+  }
+
+  token_kind kind_;
+  std::string_view str_{};
+  std::int64_t i_{0};
+  std::uint64_t u_{0U};
+  double d_{0.0};
+  bool b_{false};
+};
+
+// Tokens of a variant value, replayed per alternative.
+struct token_buffer {
+  void push(token t) {
+    if (!t.str_.empty()) {
+      t.str_ = strings_.emplace_back(t.str_);
+    }
+    tokens_.push_back(t);
+  }
+
+  std::vector<token> tokens_;
+  std::deque<std::string> strings_;
+};
+
+enum class frame_kind : std::uint8_t {
+  kArray,
+  kObject,
+  kMap,
+  kAnyArray,
+  kAnyObject,
+  kSkip,
+  kVariant
+};
+
+struct frame {
+  frame_kind kind_;
+  std::uint32_t pc_{kNoTarget};
+  std::uint32_t value_pc_{kNoTarget};
+  std::uint32_t depth_{0U};
+  std::size_t index_{0U};
+  std::uint64_t seen_{0U};
+  bool first_{true};
+  std::string key_{};
+  std::unique_ptr<token_buffer> buffer_{};
+};
+
+template <typename T>
+bool fits(token const& t) {
+  switch (t.kind_) {
+    case token_kind::kInt64: return std::in_range<T>(t.i_);
+    case token_kind::kUInt64: return std::in_range<T>(t.u_);
+    case token_kind::kDouble:
+      return std::trunc(t.d_) == t.d_ &&
+             t.d_ >= static_cast<double>(std::numeric_limits<T>::min()) &&
+             t.d_ < static_cast<double>(std::numeric_limits<T>::max()) + 1.0;
+    default: return false;
+  }
+}
+
+bool fits(number_format const f, token const& t) {
+  switch (f) {
+    case number_format::kInt8: return fits<std::int8_t>(t);
+    case number_format::kInt16: return fits<std::int16_t>(t);
+    case number_format::kInt32: return fits<std::int32_t>(t);
+    case number_format::kUInt8: return fits<std::uint8_t>(t);
+    case number_format::kUInt16: return fits<std::uint16_t>(t);
+    case number_format::kUInt32: return fits<std::uint32_t>(t);
+    case number_format::kUInt64: return fits<std::uint64_t>(t);
+    default: return fits<std::int64_t>(t);
+  }
+}
+
+struct machine {
+  machine(schema_program const& p,
+          mode const m,
+          std::uint32_t const entry,
+          std::string* out,
+          std::string prefix)
+      : p_{p}, mode_{m}, entry_{entry}, out_{out}, prefix_{std::move(prefix)} {}
+
+  void feed(token const& t) {
+    if (!stack_.empty()) {
+      auto& f = stack_.back();
+      switch (f.kind_) {
+        case frame_kind::kSkip:
+          if (t.is_begin()) {
+            ++f.depth_;
+          } else if (t.is_end() && --f.depth_ == 0U) {
+            stack_.pop_back();
+          }
+          return;
+
+        case frame_kind::kVariant:
+          f.buffer_->push(t);
+          if (t.is_begin()) {
+            ++f.depth_;
+          } else if (t.is_end() && --f.depth_ == 0U) {
+            auto const pc = f.pc_;
+            auto const buffer = std::move(f.buffer_);
+            stack_.pop_back();
+            resolve(pc, buffer->tokens_);
+          }
+          return;
+
+        default: break;
+      }
+
+      if (t.kind_ == token_kind::kKey) {
+        key(f, t.str_);
+        return;
+      } else if (t.is_end()) {
+        close(f);
+        return;
+      }
+    }
+    value(t, expected());
+  }
+
+  std::uint32_t expected() const {
+    if (stack_.empty()) {
+      return entry_;
+    }
+    auto const& f = stack_.back();
+    switch (f.kind_) {
+      case frame_kind::kArray:
+      case frame_kind::kMap: return p_.code_[f.pc_].target_;
+      case frame_kind::kObject: return f.value_pc_;
+      default: return kNoTarget;
+    }
+  }
+
+  void key(frame& f, std::string_view const k) {
+    f.key_ = k;
+    if (f.kind_ == frame_kind::kObject) {
+      auto const& ins = p_.code_[f.pc_];
+      auto const props = std::span{p_.properties_}.subspan(
+          ins.begin_, ins.end_ - ins.begin_);
+      auto const it = std::ranges::lower_bound(
+          props, k, {}, [&](schema_property const& p) -> std::string_view {
+            return p_.strings_[p.name_];
+          });
+      if (it != end(props) && p_.strings_[it->name_] == k) {
+        f.value_pc_ = it->pc_;
+        if (it->required_bit_ != schema_property::kOptional) {
+          f.seen_ |= std::uint64_t{1U} << it->required_bit_;
+        }
+      } else {
+        // Discriminators are not necessarily properties of the alternative.
+        auto const keep = mode_ == mode::kValidate ||
+                          (!keep_.empty() && stack_.size() == 1U && k == keep_);
+        f.value_pc_ = keep ? kNoTarget : kUnknown;
+      }
+      if (f.value_pc_ == kUnknown) {
+        return;
+      }
+    }
+
+    if (out_ != nullptr) {
+      if (!f.first_) {
+        out_->push_back(',');
+      }
+      write_string(k);
+      out_->push_back(':');
+    }
+    f.first_ = false;
+  }
+
+  void value(token const& t, std::uint32_t const pc) {
+    if (pc == kUnknown) {
+      if (t.is_begin()) {
+        stack_.push_back({.kind_ = frame_kind::kSkip, .depth_ = 1U});
+      }
+      return;
+    }
+
+    if (!stack_.empty() && (stack_.back().kind_ == frame_kind::kArray ||
+                            stack_.back().kind_ == frame_kind::kAnyArray)) {
+      auto& f = stack_.back();
+      if (!f.first_ && out_ != nullptr) {
+        out_->push_back(',');
+      }
+      f.first_ = false;
+      ++f.index_;
+    }
+
+    if (pc == kNoTarget) {
+      any(t);
+      return;
+    }
+
+    auto const& ins = p_.code_[pc];
+    switch (ins.op_) {
+      case opcode::kAny: any(t); break;
+
+      case opcode::kBoolean:
+        expect(t, token_kind::kBool, "boolean");
+        write(t);
+        break;
+
+      case opcode::kInteger:
+        if (!fits(ins.format_, t)) {
+          fail(t, "integer in range");
+        }
+        if (mode_ == mode::kNormalize && t.kind_ == token_kind::kDouble) {
+          write_number(t.d_ < 0.0 ? token{.kind_ = token_kind::kInt64,
+                                          .i_ = static_cast<std::int64_t>(t.d_)}
+                                  : token{.kind_ = token_kind::kUInt64,
+                                          .u_ = static_cast<std::uint64_t>(
+                                              t.d_)});
+        } else {
+          write(t);
+        }
+        break;
+
+      case opcode::kNumber: number(t, ins.format_); break;
+
+      case opcode::kString:
+        expect(t, token_kind::kString, "string");
+        write(t);
+        break;
+
+      case opcode::kDate: date(t); break;
+
+      case opcode::kEnum: {
+        expect(t, token_kind::kString, "string");
+        auto const values = std::span{p_.strings_}.subspan(
+            ins.begin_, ins.end_ - ins.begin_);
+        if (!std::ranges::binary_search(values, t.str_, std::less<>{})) {
+          fail(t, fmt::format("one of {}", fmt::join(values, ", ")));
+        }
+        write(t);
+        break;
+      }
+
+      case opcode::kArray:
+        expect(t, token_kind::kArrayBegin, "array");
+        open(t, frame_kind::kArray, pc);
+        break;
+
+      case opcode::kObject:
+        expect(t, token_kind::kObjectBegin, "object");
+        open(t, frame_kind::kObject, pc);
+        break;
+
+      case opcode::kMap:
+        expect(t, token_kind::kObjectBegin, "object");
+        open(t, frame_kind::kMap, pc);
+        break;
+
+      case opcode::kVariant:
+        if (t.is_begin()) {
+          stack_.push_back({.kind_ = frame_kind::kVariant,
+                            .pc_ = pc,
+                            .depth_ = 1U,
+                            .buffer_ = std::make_unique<token_buffer>()});
+          stack_.back().buffer_->push(t);
+        } else {
+          resolve(pc, std::span{&t, 1U});
+        }
+        break;
+    }
+  }
+
+  void any(token const& t) {
+    switch (t.kind_) {
+      case token_kind::kObjectBegin:
+        open(t, frame_kind::kAnyObject, kNoTarget);
+        break;
+      case token_kind::kArrayBegin:
+        open(t, frame_kind::kAnyArray, kNoTarget);
+        break;
+      default: write(t);
+    }
+  }
+
+  void number(token const& t, number_format const f) {
+    auto x = 0.0;
+    switch (t.kind_) {
+      case token_kind::kInt64: x = static_cast<double>(t.i_); break;
+      case token_kind::kUInt64: x = static_cast<double>(t.u_); break;
+      case token_kind::kDouble: x = t.d_; break;
+      default: fail(t, "number");
+    }
+    if (f == number_format::kFloat) {
+      if (!std::isfinite(static_cast<float>(x))) {
+        fail(t, "float in range");
+      }
+      if (mode_ == mode::kNormalize) {
+        x = static_cast<double>(static_cast<float>(x));
+      }
+    }
+    if (mode_ == mode::kNormalize) {
+      write_number(token{.kind_ = token_kind::kDouble, .d_ = x});
+    } else {
+      write(t);
+    }
+  }
+
+  void date(token const& t) {
+    expect(t, token_kind::kString, "date-time");
+    auto d = date_time_t{};
+    try {
+      parse(t.str_, d);
+    } catch (std::exception const&) {
+      fail(t, "date-time");
+    }
+    if (mode_ == mode::kNormalize) {
+      write_string_value(to_str(d));
+    } else {
+      write(t);
+    }
+  }
+
+  // Picks the alternative by discriminator or takes the first that matches.
+  template <typename Tokens>
+  void resolve(std::uint32_t const pc, Tokens const& tokens) {
+    auto const& v = p_.variants_[p_.code_[pc].target_];
+
+    if (v.discriminator_ != kNoTarget) {
+      auto const& property = p_.strings_[v.discriminator_];
+      if (tokens.front().kind_ != token_kind::kObjectBegin) {
+        fail(tokens.front(), "object");
+      }
+      auto depth = 0U;
+      for (auto i = 0U; i + 1U < tokens.size(); ++i) {
+        auto const& t = tokens[i];
+        if (t.is_begin()) {
+          ++depth;
+        } else if (t.is_end()) {
+          --depth;
+        } else if (depth == 1U && t.kind_ == token_kind::kKey &&
+                   t.str_ == property) {
+          auto const& value = tokens[i + 1U];
+          auto const tags = std::span{p_.tags_}.subspan(
+              v.tags_begin_, v.tags_end_ - v.tags_begin_);
+          auto const tag =
+              std::ranges::find_if(tags, [&](variant_tag const& x) {
+                return value.kind_ == token_kind::kString &&
+                       p_.strings_[x.value_] == value.str_;
+              });
+          if (tag == end(tags)) {
+            fail(value, fmt::format("known {}", property));
+          }
+          replay(tag->pc_, tokens, property);
+          return;
+        }
+      }
+      throw utl::fail("{}: {} not found", where(), property);
+    }
+
+    for (auto a = v.alternatives_begin_; a != v.alternatives_end_; ++a) {
+      try {
+        replay(p_.alternatives_[a], tokens, {});
+        return;
+      } catch (std::exception const&) {
+      }
+    }
+    throw utl::fail("{}: no alternative matches", where());
+  }
+
+  template <typename Tokens>
+  void replay(std::uint32_t const pc,
+              Tokens const& tokens,
+              std::string_view const keep) {
+    auto out = std::string{};
+    auto m =
+        machine{p_, mode_, pc, out_ == nullptr ? nullptr : &out, pointer()};
+    m.keep_ = keep;
+    for (auto const& t : tokens) {
+      m.feed(t);
+    }
+    if (out_ != nullptr) {
+      out_->append(out);
+    }
+  }
+
+  void open(token const& t, frame_kind const kind, std::uint32_t const pc) {
+    stack_.push_back({.kind_ = kind, .pc_ = pc});
+    write(t);
+  }
+
+  void close(frame& f) {
+    auto missing = std::string_view{};
+    if (f.kind_ == frame_kind::kObject) {
+      auto const& ins = p_.code_[f.pc_];
+      for (auto i = ins.begin_; i != ins.end_ && missing.empty(); ++i) {
+        auto const& prop = p_.properties_[i];
+        if (prop.required_bit_ != schema_property::kOptional &&
+            (f.seen_ & (std::uint64_t{1U} << prop.required_bit_)) == 0U) {
+          missing = p_.strings_[prop.name_];
+        }
+      }
+    }
+    auto const is_array =
+        f.kind_ == frame_kind::kArray || f.kind_ == frame_kind::kAnyArray;
+    stack_.pop_back();
+
+    if (!missing.empty()) {
+      throw utl::fail("{}: missing property {}", where(), missing);
+    }
+    if (out_ != nullptr) {
+      out_->push_back(is_array ? ']' : '}');
+    }
+  }
+
+  void expect(token const& t, token_kind const k, std::string_view what) const {
+    if (t.kind_ != k) {
+      fail(t, what);
+    }
+  }
+
+  [[noreturn]] void fail(token const& t, std::string_view expected) const {
+    auto const got = [&]() -> std::string {
+      switch (t.kind_) {
+        case token_kind::kObjectBegin: return "object";
+        case token_kind::kArrayBegin: return "array";
+        case token_kind::kString: return fmt::format("\"{}\"", t.str_);
+        case token_kind::kInt64: return fmt::to_string(t.i_);
+        case token_kind::kUInt64: return fmt::to_string(t.u_);
+        case token_kind::kDouble: return fmt::to_string(t.d_);
+        case token_kind::kBool: return t.b_ ? "true" : "false";
+        case token_kind::kNull: return "null";
+        default: return "?";
+      }
+    };
+    throw utl::fail("{}: expected {}, got {}", where(), expected, got());
+  }
+
+  // JSON pointer of the current value.
+  std::string pointer() const {
+    auto p = prefix_;
+    for (auto const& f : stack_) {
+      switch (f.kind_) {
+        case frame_kind::kArray:
+        case frame_kind::kAnyArray:
+          p += '/';
+          p += fmt::to_string(f.index_ == 0U ? 0U : f.index_ - 1U);
+          break;
+        case frame_kind::kObject:
+        case frame_kind::kMap:
+        case frame_kind::kAnyObject:
+          p += '/';
+          p += f.key_;
+          break;
+        default: break;
+      }
+    }
+    return p;
+  }
+
+  std::string where() const {
+    auto p = pointer();
+    return p.empty() ? "/" : p;
+  }
+
+  void write(token const& t) {
+    if (out_ == nullptr) {
+      return;
+    }
+    switch (t.kind_) {
+      case token_kind::kObjectBegin: out_->push_back('{'); break;
+      case token_kind::kArrayBegin: out_->push_back('['); break;
+      case token_kind::kString: write_string(t.str_); break;
+      case token_kind::kBool: out_->append(t.b_ ? "true" : "false"); break;
+      case token_kind::kNull: out_->append("null"); break;
+      default: write_number(t);
+    }
+  }
+
+  void write_number(token const& t) {
+    if (out_ == nullptr) {
+      return;
+    }
+    auto it = std::back_inserter(*out_);
+    switch (t.kind_) {
+      case token_kind::kInt64: fmt::format_to(it, "{}", t.i_); break;
+      case token_kind::kUInt64: fmt::format_to(it, "{}", t.u_); break;
+      default: fmt::format_to(it, "{}", t.d_);
+    }
+  }
+
+  void write_string_value(std::string_view const s) {
+    if (out_ != nullptr) {
+      write_string(s);
+    }
+  }
+
+  void write_string(std::string_view const s) {
+    out_->push_back('"');
+    for (auto const c : s) {
+      switch (c) {
+        case '"': out_->append("\\\""); break;
+        case '\\': out_->append("\\\\"); break;
+        case '\n': out_->append("\\n"); break;
+        case '\r': out_->append("\\r"); break;
+        case '\t': out_->append("\\t"); break;
+        default:
+          if (static_cast<unsigned char>(c) < 0x20U) {
+            fmt::format_to(std::back_inserter(*out_), "\\u{:04x}",
+                           static_cast<unsigned>(c));
+          } else {
+            out_->push_back(c);
+          }
+      }
+    }
+    out_->push_back('"');
+  }
+
+  schema_program const& p_;
+  mode mode_;
+  std::uint32_t entry_;
+  std::string* out_;
+  std::string prefix_;
+  std::string_view keep_;
+  std::vector<frame> stack_;
+};
+
+struct vm_handler {
+  constexpr static auto const max_object_size = std::size_t(-1);
+  constexpr static auto const max_array_size = std::size_t(-1);
+  constexpr static auto const max_key_size = std::size_t(-1);
+  constexpr static auto const max_string_size = std::size_t(-1);
+
+  explicit vm_handler(machine& m) : m_{m} {}
+
+  bool on_document_begin(json::error_code&) { return true; }
+  bool on_document_end(json::error_code&) { return true; }
+
+  bool on_object_begin(json::error_code&) {
+    return feed({.kind_ = token_kind::kObjectBegin});
+  }
+  bool on_object_end(std::size_t, json::error_code&) {
+    return feed({.kind_ = token_kind::kObjectEnd});
+  }
+  bool on_array_begin(json::error_code&) {
+    return feed({.kind_ = token_kind::kArrayBegin});
+  }
+  bool on_array_end(std::size_t, json::error_code&) {
+    return feed({.kind_ = token_kind::kArrayEnd});
+  }
+
+  bool on_key_part(json::string_view s, std::size_t, json::error_code&) {
+    buf_.append(s.data(), s.size());
+    return true;
+  }
+  bool on_key(json::string_view s, std::size_t, json::error_code&) {
+    return feed({.kind_ = token_kind::kKey, .str_ = complete(s)});
+  }
+  bool on_string_part(json::string_view s, std::size_t, json::error_code&) {
+    buf_.append(s.data(), s.size());
+    return true;
+  }
+  bool on_string(json::string_view s, std::size_t, json::error_code&) {
+    return feed({.kind_ = token_kind::kString, .str_ = complete(s)});
+  }
+
+  bool on_number_part(json::string_view, json::error_code&) { return true; }
+  bool on_int64(std::int64_t const i, json::string_view, json::error_code&) {
+    return feed({.kind_ = token_kind::kInt64, .i_ = i});
+  }
+  bool on_uint64(std::uint64_t const u, json::string_view, json::error_code&) {
+    return feed({.kind_ = token_kind::kUInt64, .u_ = u});
+  }
+  bool on_double(double const d, json::string_view, json::error_code&) {
+    return feed({.kind_ = token_kind::kDouble, .d_ = d});
+  }
+  bool on_bool(bool const b, json::error_code&) {
+    return feed({.kind_ = token_kind::kBool, .b_ = b});
+  }
+  bool on_null(json::error_code&) {
+    return feed({.kind_ = token_kind::kNull});
+  }
+
+  bool on_comment_part(json::string_view, json::error_code&) { return true; }
+  bool on_comment(json::string_view, json::error_code&) { return true; }
+
+  std::string_view complete(json::string_view const s) {
+    if (buf_.empty()) {
+      return {s.data(), s.size()};
+    }
+    buf_.append(s.data(), s.size());
+    return buf_;
+  }
+
+  bool feed(token const& t) {
+    m_.feed(t);
+    buf_.clear();
+    return true;
+  }
+
+  machine& m_;
+  std::string buf_;
+};
+
+std::string run(schema_program const& p,
+                std::string_view const s,
+                mode const m,
+                bool const write) {
+  auto out = std::string{};
+  auto vm = machine{p, m, p.entry_, write ? &out : nullptr, {}};
+  auto parser = json::basic_parser<vm_handler>{json::parse_options{}, vm};
+  auto ec = json::error_code{};
+  auto const n = parser.write_some(false, s.data(), s.size(), ec);
+  if (!ec && n != s.size()) {
+    ec = json::error::extra_data;
+  }
+  utl::verify(!ec, "invalid JSON: {}", ec.message());
+  return out;
+}
+
+}  // namespace
+
+schema_program compile_schema(YAML::Node const& root,
+                              YAML::Node const& schema) {
+  auto p = schema_program{};
+  auto c = compiler{.root_ = root, .p_ = p};
+  p.entry_ = c.compile(schema);
+  return p;
+}
+
+schema_program compile_schema(YAML::Node const& root,
+                              std::string_view const name) {
+  auto ref = YAML::Node{YAML::NodeType::Map};
+  ref["$ref"] = fmt::format("#/components/schemas/{}", name);
+  return compile_schema(root, ref);
+}
+
+std::optional<std::string> validate(schema_program const& p,
+                                    std::string_view const s) {
+  try {
+    run(p, s, mode::kValidate, false);
+    return std::nullopt;
+  } catch (std::exception const& e) {
+    return e.what();
+  }
+}
+
+std::string filter(schema_program const& p, std::string_view const s) {
+  return run(p, s, mode::kFilter, true);
+}
+
+std::string normalize(schema_program const& p, std::string_view const s) {
+  return run(p, s, mode::kNormalize, true);
+}
+
+}  // namespace openapi
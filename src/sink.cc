@@ -0,0 +1,126 @@
+#include "openapi/sink.h"
+
+#include <algorithm>
+#include <cstring>
+
+#include "zlib.h"
+
+#include "utl/verify.h"
+
+namespace openapi {
+
+struct zlib_sink::impl {
+  z_stream stream_{};
+};
+
+zlib_sink::zlib_sink(sink& next,
+                     compression const c,
+                     int const level,
+                     std::size_t const block_size)
+    : next_{next},
+      impl_{std::make_unique<impl>()},
+      block_size_{std::max(block_size, std::size_t{64U})} {
+  // windowBits 15, +16 = gzip header and trailer instead of zlib
+  auto const window_bits = c == compression::kGzip ? 15 + 16 : 15;
+  auto const ret = deflateInit2(&impl_->stream_, level, Z_DEFLATED,
+                                window_bits, 8, Z_DEFAULT_STRATEGY);
+  utl::verify(ret == Z_OK, "zlib_sink: deflateInit2 failed: {}", ret);
+  in_.reserve(block_size_);
+  out_.resize(block_size_);
+}
+
+zlib_sink::~zlib_sink() { deflateEnd(&impl_->stream_); }
+
+void zlib_sink::write(std::string_view s) {
+  utl::verify(!finished_, "zlib_sink: write after finish");
+  while (!s.empty()) {
+    auto const n = std::min(s.size(), block_size_ - in_.size());
+    in_.append(s.substr(0U, n));
+    s.remove_prefix(n);
+    if (in_.size() == block_size_) {
+      deflate_block(false);
+    }
+  }
+}
+
+void zlib_sink::finish() {
+  if (finished_) {
+    return;
+  }
+  deflate_block(true);
+  finished_ = true;
+  next_.finish();
+}
+
+void zlib_sink::deflate_block(bool const last) {
+  auto& z = impl_->stream_;
+  z.next_in = reinterpret_cast<Bytef*>(in_.data());
+  z.avail_in = static_cast<uInt>(in_.size());
+  auto ret = Z_OK;
+  do {
+    z.next_out = reinterpret_cast<Bytef*>(out_.data());
+    z.avail_out = static_cast<uInt>(out_.size());
+    ret = deflate(&z, last ? Z_FINISH : Z_NO_FLUSH);
+    utl::verify(ret != Z_STREAM_ERROR, "zlib_sink: deflate failed");
+    if (auto const n = out_.size() - z.avail_out; n != 0U) {
+      next_.write({out_.data(), n});
+    }
+  } while (last ? ret != Z_STREAM_END : z.avail_out == 0U);
+  in_.clear();
+}
+
+void json_writer::write(std::string_view s) {
+  while (!s.empty()) {
+    if (used_ == buf_.size()) {
+      flush();
+    }
+    auto const n = std::min(s.size(), buf_.size() - used_);
+    std::memcpy(buf_.data() + used_, s.data(), n);
+    used_ += n;
+    s.remove_prefix(n);
+  }
+}
+
+void json_writer::value(boost::json::value const& jv) {
+  sr_.reset(&jv);
+  drain();
+}
+
+void json_writer::key(std::string_view const k) {
+  sr_.reset(boost::json::string_view{k});
+  drain();
+  write(":");
+}
+
+void json_writer::separator(bool& first) {
+  if (!first) {
+    write(",");
+  }
+  first = false;
+}
+
+std::size_t json_writer::flush() {
+  if (used_ != 0U) {
+    sink_.write({buf_.data(), used_});
+    size_ += used_;
+    used_ = 0U;
+  }
+  return size_;
+}
+
+void json_writer::drain() {
+  while (!sr_.done()) {
+    if (used_ == buf_.size()) {
+      flush();
+    }
+    used_ += sr_.read(buf_.data() + used_, buf_.size() - used_).size();
+  }
+}
+
+std::size_t serialize(boost::json::value const& jv, sink& s) {
+  auto w = json_writer{s};
+  w.value(jv);
+  return w.flush();
+}
+
+}  // namespace openapi
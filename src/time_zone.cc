@@ -0,0 +1,109 @@
+#include "openapi/time_zone.h"
+
+#include <array>
+#include <functional>
+#include <mutex>
+#include <shared_mutex>
+
+#include "boost/unordered/unordered_flat_map.hpp"
+
+#include "date/tz.h"
+
+namespace openapi {
+
+namespace {
+
+struct string_hash {
+  using is_transparent = void;
+  std::size_t operator()(std::string_view s) const {
+    return std::hash<std::string_view>{}(s);
+  }
+};
+
+struct zone_registry {
+  std::shared_mutex mutex_;
+  boost::unordered_flat_map<std::string,
+                            date::time_zone const*,
+                            string_hash,
+                            std::equal_to<>>
+      zones_;
+};
+
+zone_registry& get_registry() {
+  static auto r = zone_registry{};
+  return r;
+}
+
+date::time_zone const* locate(std::string_view name) {
+  // Most callers render many values in the same zone.
+  thread_local auto last_name = std::string{};
+  thread_local auto last_zone = static_cast<date::time_zone const*>(nullptr);
+  if (last_zone != nullptr && last_name == name) {
+    return last_zone;
+  }
+
+  auto& r = get_registry();
+  auto zone = static_cast<date::time_zone const*>(nullptr);
+  {
+    auto const lock = std::shared_lock{r.mutex_};
+    if (auto const it = r.zones_.find(name); it != r.zones_.end()) {
+      zone = it->second;
+    }
+  }
+  if (zone == nullptr) {
+    zone = date::locate_zone(name);
+    auto const lock = std::unique_lock{r.mutex_};
+    r.zones_.emplace(std::string{name}, zone);
+  }
+
+  last_name = name;
+  last_zone = zone;
+  return zone;
+}
+
+struct range {
+  date::time_zone const* tz_{nullptr};
+  date::sys_seconds begin_, end_;
+  std::chrono::minutes offset_{};
+};
+
+constexpr auto const kCachedRanges = 8U;
+
+}  // namespace
+
+time_zone::time_zone(std::string_view name) : tz_{locate(name)} {}
+
+std::chrono::minutes time_zone::offset(
+    std::chrono::sys_time<std::chrono::milliseconds> const t) const {
+  thread_local auto ranges = std::array<range, kCachedRanges>{};
+  thread_local auto next = 0U;
+
+  for (auto const& r : ranges) {
+    if (r.tz_ == tz_ && r.begin_ <= t && t < r.end_) {
+      return r.offset_;
+    }
+  }
+
+  auto const info = tz_->get_info(t);
+  auto& r = ranges[next];
+  next = (next + 1U) % kCachedRanges;
+  r = {.tz_ = tz_,
+       .begin_ = info.begin,
+       .end_ = info.end,
+       .offset_ = std::chrono::floor<std::chrono::minutes>(info.offset)};
+  return r.offset_;
+}
+
+date_time_t time_zone::to_local(date_time_t const t) const {
+  return {t.time(), offset(t.time())};
+}
+
+std::string to_str(date_time_t const t, time_zone const& zone) {
+  return to_str(zone.to_local(t));
+}
+
+std::string to_str(date_time_t const t, std::string_view zone) {
+  return to_str(t, time_zone{zone});
+}
+
+}  // namespace openapi
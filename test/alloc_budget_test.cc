@@ -0,0 +1,144 @@
+#include "gtest/gtest.h"
+
+#include <array>
+#include <string>
+
+#include "boost/json.hpp"
+#include "boost/url/url_view.hpp"
+
+#include "openapi/date_time.h"
+#include "openapi/json.h"
+
+#include "pet-api/pet-api.h"
+#include "transit-api/transit-api.h"
+
+#include "alloc_counter.h"
+#include "transit_fixture.h"
+
+using namespace openapi;
+using namespace openapi::test;
+
+// Allocation ceilings per call. Lower them when allocations are removed,
+// never raise them without a reason.
+namespace budget {
+constexpr auto const kPetParams = 0U;
+constexpr auto const kPetToUrl = 6U;
+constexpr auto const kPetParse = 2U;
+constexpr auto const kPetDecode = 2U;
+constexpr auto const kPetEncode = 4U;
+constexpr auto const kDateUtc = 3U;
+constexpr auto const kDateOffset = 5U;
+constexpr auto const kPlanParams = 4U;
+// Per itinerary of make_plan() (2 legs, 3 places each, no intern_scope).
+constexpr auto const kItineraryDecode = 53U;
+constexpr auto const kItineraryEncode = 215U;
+constexpr auto const kSteadyDecode = 0U;
+}  // namespace budget
+
+TEST(alloc_budget, pet_params) {
+  auto const url =
+      boost::urls::url_view{"/pets?mode=WALK,BIKE&status=OFF&limit=3"};
+  auto p = pet::findPets_params{};
+  auto const params = measure([&] { p = pet::findPets_params{url.params()}; });
+  EXPECT_LE(params.allocations_, budget::kPetParams);
+
+  auto u = boost::urls::url{};
+  auto const to_url = measure([&] { u = p.to_url("/pets"); });
+  EXPECT_LE(to_url.allocations_, budget::kPetToUrl);
+  EXPECT_EQ(url.buffer(), u.buffer());
+}
+
+TEST(alloc_budget, pet_codec) {
+  auto const str = std::string{R"({"x":"OFF","y":["A","B"],"z":0})"};
+
+  auto resource = counting_resource<json::memory_resource>{
+      boost::container::pmr::new_delete_resource()};
+  auto jv = json::value{};
+  jv = json::parse(str, json::storage_ptr{&resource});
+  EXPECT_LE(resource.stats_.allocations_, budget::kPetParse);
+
+  auto item = pet::Item{};
+  auto const decode = measure([&] { item = json::value_to<pet::Item>(jv); });
+  EXPECT_LE(decode.allocations_, budget::kPetDecode);
+
+  auto out = std::string{};
+  auto const encode =
+      measure([&] { out = json::serialize(json::value_from(item)); });
+  EXPECT_LE(encode.allocations_, budget::kPetEncode);
+  EXPECT_EQ(str, out);
+}
+
+TEST(alloc_budget, decode_into_steady_state) {
+  auto const items = std::array<std::string, 2U>{
+      R"({"x":"OFF","y":["A","B"],"z":0})", R"({"x":"ON","y":["B"]})"};
+  auto const shelves = std::array<std::string, 2U>{
+      R"({"counts":{"a":1,"b":2},"labels":{"x":"first","y":"last"}})",
+      R"({"counts":{"c":3},"labels":{"z":"only"}})"};
+
+  auto item = pet::Item{};
+  auto shelf = pet::Shelf{};
+  for (auto i = 0U; i != 2U; ++i) {
+    parse_into(item, items[i]);
+    parse_into(shelf, shelves[i]);
+  }
+
+  for (auto i = 0U; i != 2U; ++i) {
+    auto const decode = measure([&] {
+      parse_into(item, items[i]);
+      parse_into(shelf, shelves[i]);
+    });
+    EXPECT_LE(decode.allocations_, budget::kSteadyDecode);
+    EXPECT_EQ(json::value_to<pet::Item>(json::parse(items[i])), item);
+    EXPECT_EQ(json::value_to<pet::Shelf>(json::parse(shelves[i])), shelf);
+  }
+  EXPECT_FALSE(item.z_.has_value());
+  EXPECT_EQ(1U, shelf.labels_->size());
+
+  auto p = pet::findPets_params{
+      boost::urls::url_view{"/pets?mode=BIKE&status=OFF&limit=3"}.params()};
+  p.reset();
+  EXPECT_EQ("/pets", p.to_url("/pets").buffer());
+}
+
+TEST(alloc_budget, date_time_parse) {
+  auto d = date_time_t{};
+  auto const utc = measure([&] { parse("2009-06-30T18:30:00Z", d); });
+  EXPECT_LE(utc.allocations_, budget::kDateUtc);
+
+  auto const offset = measure([&] { parse("2009-06-30T18:30:00+02:00", d); });
+  EXPECT_LE(offset.allocations_, budget::kDateOffset);
+}
+
+TEST(alloc_budget, transit_params) {
+  auto const url = boost::urls::url_view{
+      "/plan?fromPlace=50.1,8.6&toPlace=52.5,13.4&time=2024-01-01T10:00:00Z"
+      "&transitModes=RAIL,TRAM&maxTransfers=3"};
+  auto p = transit::plan_params{};
+  auto const params = measure([&] { p = transit::plan_params{url.params()}; });
+  EXPECT_LE(params.allocations_, budget::kPlanParams);
+  EXPECT_TRUE(p.transitModes_.contains(transit::ModeEnum::TRAM));
+}
+
+TEST(alloc_budget, transit_plan_per_itinerary) {
+  auto const measure_plan = [](unsigned const n) {
+    auto const jv = json::value_from(make_plan(n));
+    auto const str = json::serialize(jv);
+
+    auto plan = transit::Plan{};
+    auto const decode =
+        measure([&] { plan = json::value_to<transit::Plan>(jv); });
+    EXPECT_EQ(make_plan(n), plan);
+
+    auto out = std::string{};
+    auto const encode =
+        measure([&] { out = json::serialize(json::value_from(plan)); });
+    EXPECT_EQ(str, out);
+
+    return std::pair{decode.allocations_, encode.allocations_};
+  };
+
+  auto const [decode1, encode1] = measure_plan(1U);
+  auto const [decode11, encode11] = measure_plan(11U);
+  EXPECT_LE((decode11 - decode1) / 10U, budget::kItineraryDecode);
+  EXPECT_LE((encode11 - encode1) / 10U, budget::kItineraryEncode);
+}
@@ -0,0 +1,84 @@
+#include "alloc_counter.h"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdlib>
+#include <cstring>
+#include <new>
+
+namespace openapi::test {
+
+namespace {
+
+thread_local alloc_stats* current = nullptr;
+
+// Every block is preceded by a header with the requested size and the
+// header length, so frees can be subtracted from the live bytes.
+struct header {
+  std::size_t size_, offset_;
+};
+
+void* allocate(std::size_t const size, std::size_t const alignment) {
+  if (current != nullptr) {
+    ++current->allocations_;
+    current->bytes_ += size;
+    current->live_bytes_ += static_cast<std::ptrdiff_t>(size);
+    current->peak_bytes_ =
+        std::max(current->peak_bytes_, current->live_bytes_);
+  }
+  auto const offset = std::max(alignment, alignof(std::max_align_t));
+  auto const n = (offset + size + offset - 1U) / offset * offset;
+  auto const base = offset <= alignof(std::max_align_t)
+                        ? std::malloc(n)
+                        : std::aligned_alloc(offset, n);
+  if (base == nullptr) {
+    throw std::bad_alloc{};
+  }
+  auto const p = static_cast<std::byte*>(base) + offset;
+  auto const h = header{.size_ = size, .offset_ = offset};
+  std::memcpy(p - sizeof(header), &h, sizeof(h));
+  return p;
+}
+
+void deallocate(void* p) noexcept {
+  if (p == nullptr) {
+    return;
+  }
+  auto h = header{};
+  std::memcpy(&h, static_cast<std::byte*>(p) - sizeof(header), sizeof(h));
+  if (current != nullptr) {
+    ++current->deallocations_;
+    current->live_bytes_ -= static_cast<std::ptrdiff_t>(h.size_);
+  }
+  std::free(static_cast<std::byte*>(p) - h.offset_);
+}
+
+}  // namespace
+
+count_allocations::count_allocations() : prev_{current} { current = &stats_; }
+
+count_allocations::~count_allocations() { current = prev_; }
+
+}  // namespace openapi::test
+
+void* operator new(std::size_t const size) {
+  return openapi::test::allocate(size, alignof(std::max_align_t));
+}
+
+void* operator new(std::size_t const size, std::align_val_t const alignment) {
+  return openapi::test::allocate(size, static_cast<std::size_t>(alignment));
+}
+
+void operator delete(void* p) noexcept { openapi::test::deallocate(p); }
+
+void operator delete(void* p, std::size_t) noexcept {
+  openapi::test::deallocate(p);
+}
+
+void operator delete(void* p, std::align_val_t) noexcept {
+  openapi::test::deallocate(p);
+}
+
+void operator delete(void* p, std::size_t, std::align_val_t) noexcept {
+  openapi::test::deallocate(p);
+}
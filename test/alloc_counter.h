@@ -0,0 +1,69 @@
+#pragma once
+
+#include <cstddef>
+#include <utility>
+
+namespace openapi::test {
+
+struct alloc_stats {
+  std::size_t allocations_{0U};
+  std::size_t deallocations_{0U};
+  std::size_t bytes_{0U};
+
+  // Bytes allocated minus bytes freed while counting (negative when blocks
+  // from before are freed) and its maximum.
+  std::ptrdiff_t live_bytes_{0};
+  std::ptrdiff_t peak_bytes_{0};
+};
+
+// Counts calls to the global operator new/delete made by the current thread
+// while the scope is alive. Nested scopes only count into the innermost one.
+struct count_allocations {
+  count_allocations();
+  ~count_allocations();
+
+  count_allocations(count_allocations const&) = delete;
+  count_allocations(count_allocations&&) = delete;
+  count_allocations& operator=(count_allocations const&) = delete;
+  count_allocations& operator=(count_allocations&&) = delete;
+
+  alloc_stats stats_;
+  alloc_stats* prev_;
+};
+
+template <typename Fn>
+alloc_stats measure(Fn&& fn) {
+  auto const c = count_allocations{};
+  std::forward<Fn>(fn)();
+  return c.stats_;
+}
+
+// Counting mode for code that takes a memory resource (std::pmr or
+// boost::json::storage_ptr): forwards to the upstream resource.
+template <typename Resource>
+struct counting_resource final : public Resource {
+  explicit counting_resource(Resource* upstream) : upstream_{upstream} {}
+
+  void* do_allocate(std::size_t const bytes,
+                    std::size_t const alignment) override {
+    ++stats_.allocations_;
+    stats_.bytes_ += bytes;
+    return upstream_->allocate(bytes, alignment);
+  }
+
+  void do_deallocate(void* p,
+                     std::size_t const bytes,
+                     std::size_t const alignment) override {
+    ++stats_.deallocations_;
+    upstream_->deallocate(p, bytes, alignment);
+  }
+
+  bool do_is_equal(Resource const& o) const noexcept override {
+    return this == &o;
+  }
+
+  Resource* upstream_;
+  alloc_stats stats_;
+};
+
+}  // namespace openapi::test
@@ -0,0 +1,72 @@
+#include "gtest/gtest.h"
+
+#include <string>
+#include <vector>
+
+#include "boost/json.hpp"
+
+#include "openapi/etag.h"
+
+#include "pet-api/pet-api.h"
+
+#include "pet_fixture.h"
+
+using namespace openapi;
+using namespace openapi::test;
+namespace json = boost::json;
+
+TEST(etag, hash) {
+  auto const a = pet::Item{.x_ = pet::StatusEnum::ON, .y_ = {}, .z_ = 0};
+  auto b = a;
+  EXPECT_EQ(hash_of(a), hash_of(b));
+  b.z_.reset();
+  EXPECT_NE(hash_of(a), hash_of(b));
+  b.z_ = 1;
+  EXPECT_NE(hash_of(a), hash_of(b));
+
+  EXPECT_NE(hash_of(std::vector<std::string>{"ab", "c"}),
+            hash_of(std::vector<std::string>{"a", "bc"}));
+  EXPECT_NE(hash_of(pet::Pet{pet::Cat{.petType_ = "x", .name_ = "y"}}),
+            hash_of(pet::Pet{pet::Dog{.petType_ = "x"}}));
+
+  auto shelf =
+      pet::Shelf{.extra_ = {{{"a", json::parse(R"([1,2.5,"x",null])")}}}};
+  for (auto i = 0; i != 100; ++i) {
+    shelf.counts_.emplace(std::to_string(i), i);
+  }
+  auto copy = pet::Shelf{.extra_ = shelf.extra_};
+  for (auto i = 99; i != -1; --i) {
+    copy.counts_.emplace(std::to_string(i), i);
+  }
+  EXPECT_EQ(hash_of(shelf), hash_of(copy));
+  copy.extra_->at("a").as_array()[0] = std::uint64_t{1U};
+  EXPECT_EQ(hash_of(shelf), hash_of(copy));
+  copy.extra_->at("a") = json::parse(R"([1,2.5,"x",false])");
+  EXPECT_NE(hash_of(shelf), hash_of(copy));
+
+  EXPECT_EQ(hash_of(json::parse(R"({"a":1,"b":{"c":2,"d":3}})")),
+            hash_of(json::parse(R"({"b":{"d":3,"c":2},"a":1})")));
+  EXPECT_NE(hash_of(json::parse(R"({"a":1,"b":2})")),
+            hash_of(json::parse(R"({"a":2,"b":1})")));
+  EXPECT_NE(hash_of(json::parse(R"({"a":1})")),
+            hash_of(json::parse(R"({"a":1,"b":null})")));
+}
+
+TEST(etag, conditional_request) {
+  auto const items = make_items(100U);
+  auto const tag = pet::getItems_response_etag(items);
+  EXPECT_EQ(20U, tag.size());
+  EXPECT_TRUE(tag.starts_with("W/\""));
+
+  auto combined = std::string{};
+  EXPECT_EQ(pet::encode_getItems_response(items),
+            pet::encode_getItems_response(items, combined));
+  EXPECT_EQ(tag, combined);
+
+  EXPECT_TRUE(etag_matches(tag, tag));
+  EXPECT_TRUE(etag_matches("*", tag));
+  EXPECT_TRUE(etag_matches(R"("x", )" + tag, tag));
+  EXPECT_TRUE(etag_matches(R"("x", )" + tag.substr(2U), tag));
+  EXPECT_FALSE(etag_matches(R"("x", "y")", tag));
+  EXPECT_FALSE(etag_matches("", tag));
+}
@@ -1,6 +1,9 @@
 #include "gtest/gtest.h"
 
+#include <functional>
+#include <limits>
 #include <regex>
+#include <sstream>
 
 #include "yaml-cpp/yaml.h"
 
@@ -11,9 +14,14 @@
 
 #include "openapi/gen_types.h"
 #include "openapi/json.h"
+#include "openapi/merge_patch.h"
 #include "openapi/parse.h"
 
+#include "events-api/events-api.h"
+#include "pet-api/pet-api.h"
+
 using namespace openapi;
+using namespace pet;
 
 enum class mode { WALK, TRANSIT };
 
@@ -65,4 +73,421 @@ TEST(openapi, parse_expect_default_value) {
       boost::urls::url_view{"/"}.params(), "mode",
       std::vector<mode>{mode::TRANSIT, mode::WALK});
   EXPECT_EQ((std::vector{mode::TRANSIT, mode::WALK}), v);
-}
\ No newline at end of file
+}
+
+TEST(openapi, number_array_roundtrip) {
+  auto const val = Track{.points_ = {1.5, -2.0, 3.0}, .weights_ = std::nullopt};
+  auto const json = json::serialize(json::value_from(val));
+  auto const vx = json::value_to<Track>(json::parse(json));
+  EXPECT_EQ(val, vx);
+
+  auto const with_weights =
+      json::value_to<Track>(json::parse(R"({"points":[1,2],"weights":[0.5]})"));
+  EXPECT_EQ((std::vector<double>{1.0, 2.0}), with_weights.points_);
+  ASSERT_TRUE(with_weights.weights_.has_value());
+  EXPECT_EQ((std::vector<double>{0.5}), *with_weights.weights_);
+
+  EXPECT_THROW(json::value_to<Track>(json::parse(R"({"points":[1,"x"]})")),
+               std::runtime_error);
+}
+
+TEST(openapi, number_array_from_text) {
+  // decode_addTrack_body reads the numbers from the text, no json::array.
+  auto const t = decode_addTrack_body(
+      R"({"x":[[1,2],{"a":3}],"points":[1,-2.5,1e3],"weights":[]})");
+  EXPECT_EQ((std::vector<double>{1.0, -2.5, 1e3}), t.points_);
+  EXPECT_EQ(std::vector<double>{}, t.weights_);
+
+  auto into = Track{.points_ = {7.0}, .weights_ = std::vector{1.0}};
+  decode_addTrack_body_into(into, R"({"points":[9007199254740993,2]})");
+  EXPECT_EQ((std::vector<double>{9007199254740993.0, 2.0}), into.points_);
+  EXPECT_FALSE(into.weights_.has_value());
+
+  auto const error = [](std::string_view const s) {
+    try {
+      decode_addTrack_body(s);
+    } catch (std::exception const& e) {
+      return std::string{e.what()};
+    }
+    return std::string{};
+  };
+  EXPECT_EQ(R"(/points/1: expected number, got "x")",
+            error(R"({"points":[1,"x"]})"));
+  EXPECT_EQ("/weights/0: expected number, got [1]",
+            error(R"({"points":[],"weights":[[1]]})"));
+  EXPECT_EQ("/: missing property points", error("{}"));
+}
+
+TEST(openapi, additional_properties) {
+  auto const jv = json::parse(
+      R"({"counts":{"a":1,"b":2},"labels":{"z":"last","a":"first"},)"
+      R"("extra":{"x":[1,2]}})");
+  auto const shelf = json::value_to<Shelf>(jv);
+  EXPECT_EQ(2U, shelf.counts_.size());
+  EXPECT_EQ(2, shelf.counts_.at("b"));
+  ASSERT_TRUE(shelf.extra_.has_value());
+  EXPECT_EQ(json::value_from(std::vector{1, 2}), shelf.extra_->at("x"));
+
+  ASSERT_TRUE(shelf.labels_.has_value());
+  EXPECT_EQ("first", shelf.labels_->at("a"));
+  EXPECT_EQ(R"({"z":"last","a":"first"})",
+            json::serialize(json::value_from(*shelf.labels_)));
+
+  EXPECT_EQ(shelf, json::value_to<Shelf>(json::value_from(shelf)));
+}
+
+TEST(openapi, additional_next_to_properties) {
+  constexpr auto const kText =
+      std::string_view{R"({"id":"g","temp":21.5,"samples":[1,2],"hum":40})"};
+  auto const gauge = json::value_to<Gauge>(json::parse(kText));
+  EXPECT_EQ("g", gauge.id_);
+  EXPECT_EQ((std::vector<double>{1.0, 2.0}), gauge.samples_);
+  EXPECT_EQ((boost::unordered_flat_map<std::string, double>{{"temp", 21.5},
+                                                             {"hum", 40.0}}),
+            gauge.additional_);
+  EXPECT_EQ(gauge, read_json<Gauge>(kText));
+  EXPECT_EQ(gauge, json::value_to<Gauge>(json::value_from(gauge)));
+
+  auto s = std::string{};
+  auto out = string_sink{s};
+  encode(gauge, out);
+  EXPECT_EQ(gauge, json::value_to<Gauge>(json::parse(s)));
+
+  // Decoding into an existing value drops entries that are gone.
+  auto reused = gauge;
+  decode_into(reused, json::parse(R"({"id":"h","wind":3})"));
+  EXPECT_EQ((Gauge{.id_ = "h", .additional_ = {{"wind", 3.0}}}), reused);
+  read_json_into(reused, R"({"id":"i"})");
+  EXPECT_EQ(Gauge{.id_ = "i"}, reused);
+
+  auto const error = [](std::string_view const s) {
+    try {
+      read_json<Gauge>(s);
+    } catch (std::exception const& e) {
+      return std::string{e.what()};
+    }
+    return std::string{};
+  };
+  EXPECT_TRUE(error(R"({"id":"g","temp":"x"})").starts_with("/temp: "));
+  EXPECT_THROW(json::value_to<Gauge>(json::parse(R"({"id":"g","temp":[]})")),
+               std::exception);
+}
+
+TEST(openapi, ordered_map) {
+  auto m = openapi::ordered_map<int>{};
+  for (auto i = 0; i != 100; ++i) {
+    m.emplace(std::to_string(99 - i), i);
+  }
+  EXPECT_EQ(100U, m.size());
+  EXPECT_EQ("99", m.begin()->first);
+  EXPECT_EQ(42, m.at("57"));
+  EXPECT_FALSE(m.emplace("57", 0).second);
+
+  auto copy = m;
+  auto moved = std::move(copy);
+  EXPECT_EQ(m, moved);
+  EXPECT_EQ(42, moved.at("57"));
+  EXPECT_FALSE(moved.contains("100"));
+}
+
+TEST(openapi, enum_set_params) {
+  static_assert(sizeof(modeEnumSet) == 1U);
+
+  auto const defaults =
+      findPets_params{boost::urls::url_view{"/pets?limit=3"}.params()};
+  EXPECT_EQ((modeEnumSet{modeEnum::WALK, modeEnum::TRANSIT}), defaults.mode_);
+  EXPECT_FALSE(defaults.status_.has_value());
+  EXPECT_EQ(3, defaults.limit_);
+  EXPECT_EQ("/pets?limit=3", defaults.to_url("/pets").buffer());
+
+  auto const p = findPets_params{
+      boost::urls::url_view{"/pets?mode=BIKE,WALK&status=OFF&limit=1"}
+          .params()};
+  EXPECT_TRUE(p.mode_.contains(modeEnum::BIKE));
+  EXPECT_TRUE(p.mode_.contains(modeEnum::WALK));
+  EXPECT_FALSE(p.mode_.contains(modeEnum::TRANSIT));
+  EXPECT_EQ(2U, p.mode_.size());
+  ASSERT_TRUE(p.status_.has_value());
+  EXPECT_EQ(StatusEnumSet{StatusEnum::OFF}, *p.status_);
+
+  auto const url = p.to_url("/pets");
+  EXPECT_EQ("/pets?mode=WALK,BIKE&status=OFF&limit=1", url.buffer());
+  auto const parsed = findPets_params{url.params()};
+  EXPECT_EQ(p.mode_, parsed.mode_);
+  EXPECT_EQ(p.status_, parsed.status_);
+
+  EXPECT_THROW(
+      findPets_params{boost::urls::url_view{"/pets?mode=CAR&limit=1"}.params()},
+      std::runtime_error);
+}
+
+TEST(openapi, enum_set_json) {
+  auto const s = modeEnumSet{modeEnum::TRANSIT, modeEnum::WALK};
+  auto const jv = json::value_from(s);
+  EXPECT_EQ(R"(["WALK","TRANSIT"])", json::serialize(jv));
+  EXPECT_EQ(s, json::value_to<modeEnumSet>(jv));
+}
+
+TEST(openapi, one_of_discriminator) {
+  auto const cat = json::value_to<Pet>(
+      json::parse(R"({"petType":"kitty","name":"Tom","lives":9})"));
+  ASSERT_TRUE(std::holds_alternative<Cat>(cat));
+  EXPECT_EQ("Tom", std::get<Cat>(cat).name_);
+
+  auto const by_name =
+      json::value_to<Pet>(json::parse(R"({"petType":"Cat","name":"Tom"})"));
+  EXPECT_TRUE(std::holds_alternative<Cat>(by_name));
+
+  auto const dog =
+      json::value_to<Pet>(json::parse(R"({"petType":"Dog","bark":true})"));
+  ASSERT_TRUE(std::holds_alternative<Dog>(dog));
+  EXPECT_TRUE(std::get<Dog>(dog).bark_);
+
+  auto const encoded = json::value_from(Pet{Cat{.name_ = "Felix"}});
+  EXPECT_EQ("kitty", encoded.at("petType").as_string());
+  EXPECT_EQ(Pet{Cat{.petType_ = "kitty", .name_ = "Felix"}},
+            json::value_to<Pet>(encoded));
+
+  EXPECT_THROW(json::value_to<Pet>(json::parse(R"({"petType":"Cow"})")),
+               std::runtime_error);
+  EXPECT_THROW(json::value_to<Pet>(json::parse(R"({"name":"Tom"})")),
+               std::runtime_error);
+}
+
+TEST(openapi, any_of_trial) {
+  auto const animal =
+      json::value_to<Animal>(json::parse(R"({"petType":"x","name":"Tom"})"));
+  ASSERT_TRUE(std::holds_alternative<Cat>(animal));
+  EXPECT_EQ(animal, json::value_to<Animal>(json::value_from(animal)));
+  EXPECT_THROW(json::value_to<Animal>(json::parse(R"({"petType":"x"})")),
+               std::runtime_error);
+}
+
+TEST(openapi, inline_one_of_rejected) {
+  auto const spec = YAML::Load(R"(
+components:
+  schemas:
+    Box:
+      type: object
+      properties:
+        content:
+          oneOf:
+            - type: string
+            - type: integer
+)");
+  auto header = std::stringstream{};
+  auto source = std::stringstream{};
+  EXPECT_THROW(write_types(spec, "box.h", header, source, "box"),
+               std::runtime_error);
+}
+
+TEST(openapi, variant_dispatch) {
+  constexpr auto const kAlternatives = 12U;
+
+  auto arr = json::array{};
+  for (auto i = 0U; i != kAlternatives; ++i) {
+    arr.emplace_back(json::object{{"type", "Event" + std::to_string(i)},
+                                  {"value" + std::to_string(i), i}});
+  }
+  auto const jv = json::value{std::move(arr)};
+
+  auto const tagged = json::value_to<std::vector<events::Event>>(jv);
+  auto const untagged = json::value_to<std::vector<events::UntaggedEvent>>(jv);
+  ASSERT_EQ(kAlternatives, tagged.size());
+  ASSERT_EQ(kAlternatives, untagged.size());
+  for (auto i = 0U; i != kAlternatives; ++i) {
+    EXPECT_EQ(i, tagged[i].index());
+    EXPECT_EQ(i, untagged[i].index());
+  }
+}
+
+TEST(openapi, all_of_flattened) {
+  auto const tiger = json::value_to<Tiger>(
+      json::parse(R"({"petType":"Tiger","name":"Shere Khan","stripes":42})"));
+  EXPECT_EQ("Shere Khan", tiger.name_);
+  EXPECT_EQ(42, tiger.stripes_);
+  EXPECT_FALSE(tiger.lives_.has_value());
+  EXPECT_THROW(
+      json::value_to<Tiger>(json::parse(R"({"petType":"Tiger","name":"x"})")),
+      std::runtime_error);
+}
+
+TEST(openapi, compact_layout) {
+  static_assert(sizeof(compact_optional<double>) == sizeof(double));
+  static_assert(sizeof(compact_optional<bool>) == 1U);
+  // Without a range excluding the sentinel, INT64_MIN has to stay valid.
+  static_assert(std::is_same_v<decltype(Sighting::count_),
+                               compact_optional<std::int64_t>>);
+  static_assert(std::is_same_v<decltype(Sighting::delta_),
+                               std::optional<std::int64_t>>);
+
+  auto const str = std::string{
+      R"({"seen":true,"id":7,"status":"OFF","name":"Rex","lat":5E-1,)"
+      R"("indoor":false,"count":3})"};
+  auto const s = json::value_to<Sighting>(json::parse(str));
+  EXPECT_EQ(true, s.seen_.value());
+  EXPECT_EQ(StatusEnum::OFF, *s.status_);
+  EXPECT_EQ(0.5, s.lat_.value());
+  EXPECT_EQ(false, s.indoor_.value());
+
+  // Storage is reordered, JSON keeps the spec order.
+  EXPECT_EQ(str, json::serialize(json::value_from(s)));
+
+  auto const empty = json::value_to<Sighting>(json::parse(R"({"id":1})"));
+  EXPECT_FALSE(empty.seen_.has_value());
+  EXPECT_FALSE(empty.lat_.has_value());
+  EXPECT_EQ(std::nullopt, empty.status_);
+  EXPECT_EQ(R"({"id":1})", json::serialize(json::value_from(empty)));
+  EXPECT_LT(empty, s);
+
+  auto const min = json::value_to<Sighting>(
+      json::parse(R"({"id":1,"delta":-9223372036854775808})"));
+  EXPECT_EQ(std::numeric_limits<std::int64_t>::min(), min.delta_);
+
+  auto report = std::stringstream{};
+  write_layout_report(report);
+  auto const r = report.str();
+  auto m = std::smatch{};
+  ASSERT_TRUE(
+      std::regex_search(r, m, std::regex{R"(Sighting: (\d+) -> (\d+) bytes)"}));
+  EXPECT_EQ(sizeof(Sighting), std::stoul(m[2]));
+  EXPECT_LT(std::stoul(m[2]), std::stoul(m[1]));
+
+  // Structs without x-compact are listed unchanged.
+  ASSERT_TRUE(
+      std::regex_search(r, m, std::regex{R"(Reading: (\d+) -> (\d+) bytes)"}));
+  EXPECT_EQ(sizeof(Reading), std::stoul(m[1]));
+  EXPECT_EQ(sizeof(Reading), std::stoul(m[2]));
+}
+
+TEST(openapi, number_formats) {
+  static_assert(std::is_same_v<decltype(Reading::sensor_), std::int32_t>);
+  static_assert(std::is_same_v<decltype(Reading::value_), float>);
+  static_assert(std::is_same_v<decltype(Reading::level_), std::uint8_t>);
+  static_assert(
+      std::is_same_v<decltype(Reading::weight_), std::optional<double>>);
+  static_assert(
+      std::is_same_v<std::underlying_type_t<StatusEnum>, std::uint8_t>);
+
+  auto const r = json::value_to<Reading>(json::parse(
+      R"({"sensor":-7,"value":0.5,"level":255,"total":5000000000})"));
+  EXPECT_EQ(-7, r.sensor_);
+  EXPECT_EQ(0.5F, r.value_);
+  EXPECT_EQ(255U, r.level_);
+  EXPECT_EQ(5000000000, r.total_);
+  EXPECT_EQ(r, json::value_to<Reading>(json::value_from(r)));
+
+  for (auto const bad : {R"({"sensor":2147483648,"value":0,"level":0})",
+                         R"({"sensor":1.5,"value":0,"level":0})",
+                         R"({"sensor":0,"value":1E39,"level":0})",
+                         R"({"sensor":0,"value":0,"level":256})",
+                         R"({"sensor":0,"value":0,"level":-1})"}) {
+    EXPECT_THROW(json::value_to<Reading>(json::parse(bad)), std::runtime_error)
+        << bad;
+  }
+
+  auto const params =
+      boost::urls::url_view{"/?a=7&b=256&c=18446744073709551615&d=-1"}
+          .params();
+  EXPECT_EQ(7, parse_param<std::int32_t>(params, "a"));
+  EXPECT_EQ(256, parse_param<std::uint16_t>(params, "b"));
+  EXPECT_THROW(parse_param<std::uint8_t>(params, "b"), std::runtime_error);
+  EXPECT_EQ(std::numeric_limits<std::uint64_t>::max(),
+            parse_param<std::uint64_t>(params, "c"));
+  EXPECT_THROW(parse_param<std::uint64_t>(params, "d"), std::runtime_error);
+}
+
+TEST(openapi, decode_error_path) {
+  auto const error = [](std::string_view const s) {
+    try {
+      json::value_to<Track>(json::parse(s));
+    } catch (std::exception const& e) {
+      return std::string{e.what()};
+    }
+    return std::string{};
+  };
+  EXPECT_EQ(R"(/points/1: expected number, got "x")",
+            error(R"({"points":[1,"x"]})"));
+  EXPECT_EQ("/: missing property points", error("{}"));
+
+  auto items = std::vector<Item>{};
+  try {
+    decode_into(items, json::parse(R"([{"x":"ON","y":[]},)"
+                                   R"({"x":"ON","y":["C"]}])"));
+    FAIL();
+  } catch (std::exception const& e) {
+    EXPECT_TRUE(std::string_view{e.what()}.starts_with("/1/y/0: ")) << e.what();
+  }
+
+  try {
+    json::value_to<Reading>(
+        json::parse(R"({"sensor":0,"value":0,"level":256})"));
+    FAIL();
+  } catch (std::exception const& e) {
+    EXPECT_TRUE(std::string_view{e.what()}.starts_with("/level: invalid"));
+  }
+}
+
+template <typename T>
+concept json_decodable =
+    requires(T& t, json::value const& jv) { decode_into(t, jv); };
+
+template <typename T>
+concept msgpack_decodable =
+    requires(T& t, msgpack_reader& r) { msgpack_read(r, t); };
+
+TEST(openapi, borrowed_strings) {
+  static_assert(std::is_same_v<decltype(Tag::name_), std::string_view>);
+  static_assert(std::is_same_v<decltype(Tag::aliases_),
+                               std::optional<std::vector<std::string_view>>>);
+
+  // The views would dangle: only document<Tag> decodes.
+  static_assert(json_decodable<Item> && !json_decodable<Tag>);
+  static_assert(!json_decodable<std::string_view>);
+  static_assert(msgpack_decodable<Item> && !msgpack_decodable<Tag>);
+  static_assert(merge_patchable<Item> && !merge_patchable<Tag>);
+  static_assert(diffable<Tag>);
+
+  auto const body = std::string{
+      R"({"name":"dog","aliases":["hound","\"pup\""],"note":"good boy"})"};
+
+  // The views point into the document, the input does not need to outlive it.
+  auto const doc = decode_addTag_body(std::string{body});
+  EXPECT_EQ("dog", doc->name_);
+  ASSERT_TRUE(doc->aliases_.has_value());
+  EXPECT_EQ((std::vector<std::string_view>{"hound", "\"pup\""}),
+            *doc->aliases_);
+  EXPECT_EQ("good boy", doc->note_);
+  EXPECT_FALSE(doc->weight_.has_value());
+
+  EXPECT_EQ(body, json::serialize(json::value_from(*doc)));
+
+  // Strings without escapes view into the document's copy of the input.
+  auto const in_buffer = [&](std::string_view const s) {
+    return std::less_equal<>{}(doc.buffer_.data(), s.data()) &&
+           std::less_equal<>{}(s.data() + s.size(),
+                               doc.buffer_.data() + doc.buffer_.size());
+  };
+  EXPECT_TRUE(in_buffer(doc->name_));
+  EXPECT_TRUE(in_buffer(doc->aliases_->at(0)));
+  EXPECT_FALSE(in_buffer(doc->aliases_->at(1)));
+
+  // Unknown members are skipped, errors carry the JSON pointer.
+  auto const skipped = decode_addTag_body(
+      R"({"x":{"a":[1,{"b":"c"}]},"name":"cat","weight":3,"y":[]})");
+  EXPECT_EQ("cat", skipped->name_);
+  EXPECT_EQ(3, skipped->weight_);
+
+  auto const error = [](std::string_view const s) {
+    try {
+      decode_addTag_body(s);
+    } catch (std::exception const& e) {
+      return std::string{e.what()};
+    }
+    return std::string{};
+  };
+  EXPECT_EQ("/aliases/1: expected string, got int64",
+            error(R"({"name":"x","aliases":["a",1]})"));
+  EXPECT_EQ("/: missing property name", error(R"({"note":"x"})"));
+  EXPECT_TRUE(error(R"({"name":"x","weight":"3"})").starts_with("/weight: "));
+}
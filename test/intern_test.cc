@@ -0,0 +1,60 @@
+#include "gtest/gtest.h"
+
+#include <string>
+
+#include "boost/json.hpp"
+
+#include "openapi/intern.h"
+#include "openapi/json.h"
+
+#include "transit-api/transit-api.h"
+
+#include "alloc_counter.h"
+#include "transit_fixture.h"
+
+using namespace openapi;
+
+TEST(intern, pool) {
+  auto pool = intern_pool{};
+  auto const a = [&]() {
+    auto const scope = intern_scope{pool};
+    return std::pair{interned_string{"Deutsche Bahn Fernverkehr"},
+                     interned_string{std::string{"Deutsche Bahn Fernverkehr"}}};
+  }();
+  EXPECT_EQ(a.first.p_, a.second.p_);
+  EXPECT_EQ(1U, pool.size());
+  EXPECT_EQ(1U, pool.hits_);
+
+  auto const b = interned_string{"Deutsche Bahn Fernverkehr"};
+  EXPECT_NE(a.first.p_, b.p_);
+  EXPECT_EQ(a.first, b);
+  EXPECT_EQ(nullptr, current_intern_pool());
+
+  EXPECT_EQ(R"("x")", json::serialize(json::value_from(interned_string{"x"})));
+  EXPECT_EQ("", interned_string{}.view());
+}
+
+TEST(intern, memory_savings) {
+  auto const jv = json::value_from(test::make_city_plan());
+
+  auto plain = transit::Plan{};
+  auto const without =
+      test::measure([&] { plain = json::value_to<transit::Plan>(jv); });
+
+  auto interned = transit::Plan{};
+  auto hits = std::size_t{0U};
+  auto const with = test::measure([&] {
+    auto pool = intern_pool{};
+    auto const scope = intern_scope{pool};
+    interned = json::value_to<transit::Plan>(jv);
+    hits = pool.hits_;
+  });
+
+  EXPECT_EQ(plain, interned);
+  EXPECT_EQ(interned.itineraries_[0].legs_[0].agencyName_->p_,
+            interned.itineraries_[4].legs_[0].agencyName_->p_);
+
+  EXPECT_LT(0U, hits);
+  EXPECT_LT(with.bytes_, without.bytes_);
+  EXPECT_LT(with.allocations_, without.allocations_);
+}
@@ -1,5 +1,6 @@
 #include "gtest/gtest.h"
 
+#include "openapi/document.h"
 #include "openapi/json.h"
 
 using namespace openapi;
@@ -109,4 +110,35 @@ struct Item {
   Status x;
   Pets y;
   std::optional<int> z;
-};
\ No newline at end of file
+};
+
+TEST(json, read_numbers) {
+  auto v = std::vector<double>{};
+  read_numbers(
+      json::parse(" [1, -2, 3.5, 18446744073709551615, 1e3 ] ").as_array(), v);
+  EXPECT_EQ((std::vector<double>{1.0, -2.0, 3.5, 18446744073709551615.0, 1e3}),
+            v);
+
+  read_numbers(json::array{}, v);
+  EXPECT_TRUE(v.empty());
+
+  EXPECT_THROW(read_numbers(json::parse(R"([1, "2"])").as_array(), v),
+               std::runtime_error);
+  EXPECT_THROW(read_numbers(json::parse("[[1]]").as_array(), v),
+               std::runtime_error);
+}
+
+TEST(json, parse_numbers) {
+  auto v = std::vector<double>{};
+  parse_numbers(" [1, -2, 3.5, 18446744073709551615, 1e3 ] ", v);
+  EXPECT_EQ((std::vector<double>{1.0, -2.0, 3.5, 18446744073709551615.0, 1e3}),
+            v);
+
+  parse_numbers("[]", v);
+  EXPECT_TRUE(v.empty());
+
+  EXPECT_THROW(parse_numbers(R"([1, "2"])", v), std::runtime_error);
+  EXPECT_THROW(parse_numbers("[[1]]", v), std::runtime_error);
+  EXPECT_THROW(parse_numbers("[1,", v), std::runtime_error);
+  EXPECT_THROW(parse_numbers("{}", v), std::exception);
+}
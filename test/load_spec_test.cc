@@ -0,0 +1,172 @@
+#include "gtest/gtest.h"
+
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "openapi/gen_types.h"
+#include "openapi/load_spec.h"
+
+namespace fs = std::filesystem;
+using namespace openapi;
+
+namespace {
+
+constexpr auto const kRoot = R"({
+  "openapi": "3.0.0",
+  "paths": {},
+  "components": {
+    "schemas": {
+      "Order": {
+        "type": "object",
+        "required": ["id"],
+        "properties": {
+          "id": {"type": "integer"},
+          "price": {"$ref": "common.yml#/components/schemas/Money"},
+          "shipTo": {"$ref": "shared/address.yml"}
+        }
+      }
+    }
+  }
+})";
+
+constexpr auto const kCommon = R"(
+components:
+  schemas:
+    Money:
+      type: object
+      properties:
+        amount:
+          type: number
+        currency:
+          $ref: '#/components/schemas/Currency'
+    Currency:
+      type: string
+      enum: [EUR, USD]
+)";
+
+constexpr auto const kAddress = R"(
+type: object
+properties:
+  city:
+    type: string
+)";
+
+constexpr auto const kApi = R"(
+openapi: 3.0.0
+paths:
+  /orders:
+    get:
+      parameters:
+        - $ref: 'common.yml#/components/parameters/Limit'
+      responses:
+        '404':
+          $ref: 'not-found.yml'
+)";
+
+constexpr auto const kParameters = R"(
+components:
+  parameters:
+    Limit:
+      name: limit
+      in: query
+      schema:
+        $ref: 'money.yml'
+)";
+
+constexpr auto const kNotFound = R"(
+description: not found
+)";
+
+constexpr auto const kMoney = R"(
+type: number
+)";
+
+void write(fs::path const& p, std::string_view content) {
+  fs::create_directories(p.parent_path());
+  auto out = std::ofstream{p};
+  out << content;
+}
+
+std::string generate(YAML::Node const& spec) {
+  auto header = std::stringstream{};
+  auto source = std::stringstream{};
+  write_types(spec, "order.h", header, source, "order");
+  return header.str() + source.str();
+}
+
+}  // namespace
+
+TEST(load_spec, external_refs_and_cache) {
+  auto const dir = fs::temp_directory_path() / "openapi-load-spec-test";
+  fs::remove_all(dir);
+  write(dir / "order.json", kRoot);
+  write(dir / "common.yml", kCommon);
+  write(dir / "shared" / "address.yml", kAddress);
+
+  auto const spec = load_spec(dir / "order.json");
+  auto const schemas = spec["components"]["schemas"];
+  EXPECT_EQ("#/components/schemas/Money",
+            schemas["Order"]["properties"]["price"]["$ref"].as<std::string>());
+  EXPECT_EQ("#/components/schemas/address",
+            schemas["Order"]["properties"]["shipTo"]["$ref"].as<std::string>());
+  EXPECT_EQ(
+      "#/components/schemas/Currency",
+      schemas["Money"]["properties"]["currency"]["$ref"].as<std::string>());
+  EXPECT_TRUE(schemas["Currency"].IsDefined());
+  EXPECT_EQ("string", schemas["address"]["properties"]["city"]["type"]
+                          .as<std::string>());
+
+  auto const expected = generate(spec);
+  auto const cache = dir / "cache";
+  EXPECT_EQ(expected, generate(load_spec(dir / "order.json", cache)));
+  EXPECT_EQ(expected, generate(load_spec(dir / "order.json", cache)));
+
+  // Changing a referenced file invalidates the resolved document.
+  write(dir / "shared" / "address.yml",
+        std::string{kAddress} + "  zip:\n    type: string\n");
+  auto const changed = load_spec(dir / "order.json", cache);
+  EXPECT_TRUE(changed["components"]["schemas"]["address"]["properties"]["zip"]
+                  .IsDefined());
+
+  fs::remove_all(dir);
+}
+
+TEST(load_spec, components_sections_and_dependencies) {
+  auto const dir = fs::temp_directory_path() / "openapi-load-spec-sections";
+  fs::remove_all(dir);
+  write(dir / "api.yml", kApi);
+  write(dir / "common.yml", kParameters);
+  write(dir / "not-found.yml", kNotFound);
+  write(dir / "money.yml", kMoney);
+
+  auto deps = std::vector<fs::path>{};
+  auto const spec = load_spec(dir / "api.yml", std::nullopt, &deps);
+  auto const get = spec["paths"]["/orders"]["get"];
+  EXPECT_EQ("#/components/parameters/Limit",
+            get["parameters"][0]["$ref"].as<std::string>());
+  EXPECT_EQ("#/components/responses/not-found",
+            get["responses"]["404"]["$ref"].as<std::string>());
+
+  auto const components = spec["components"];
+  EXPECT_EQ("limit",
+            components["parameters"]["Limit"]["name"].as<std::string>());
+  EXPECT_EQ("#/components/schemas/money",
+            components["parameters"]["Limit"]["schema"]["$ref"]
+                .as<std::string>());
+  EXPECT_EQ("number", components["schemas"]["money"]["type"].as<std::string>());
+  EXPECT_EQ("not found", components["responses"]["not-found"]["description"]
+                             .as<std::string>());
+  EXPECT_EQ(4U, deps.size());
+
+  // A cache hit reports the same files.
+  auto const cache = dir / "cache";
+  load_spec(dir / "api.yml", cache);
+  auto cached_deps = std::vector<fs::path>{};
+  load_spec(dir / "api.yml", cache, &cached_deps);
+  EXPECT_EQ(deps, cached_deps);
+
+  fs::remove_all(dir);
+}
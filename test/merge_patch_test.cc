@@ -0,0 +1,95 @@
+#include "gtest/gtest.h"
+
+#include <string>
+
+#include "boost/json.hpp"
+
+#include "openapi/merge_patch.h"
+
+#include "pet-api/pet-api.h"
+#include "transit-api/transit-api.h"
+
+#include "transit_fixture.h"
+
+using namespace openapi;
+using namespace openapi::test;
+using namespace std::chrono_literals;
+namespace json = boost::json;
+
+TEST(merge_patch, json_value) {
+  // RFC 7386 appendix A
+  auto target = json::parse(R"({"a":"b","c":{"d":"e","f":"g"}})");
+  apply_patch(target, json::parse(R"({"a":"z","c":{"f":null}})"));
+  EXPECT_EQ(json::parse(R"({"a":"z","c":{"d":"e"}})"), target);
+
+  auto const from = json::parse(R"({"a":[1,2],"b":{"c":1,"d":2},"e":3})");
+  auto const to = json::parse(R"({"a":[1],"b":{"c":1,"d":3},"f":4})");
+  auto const patch = diff(from, to);
+  EXPECT_EQ(json::parse(R"({"e":null,"a":[1],"b":{"d":3},"f":4})"), patch);
+  auto x = from;
+  apply_patch(x, patch);
+  EXPECT_EQ(to, x);
+}
+
+TEST(merge_patch, generated_types) {
+  auto const from = pet::Shelf{
+      .counts_ = {{"a", 1}, {"b", 2}},
+      .labels_ = pet::Labels{{"x", "1"}},
+      .extra_ = {{{"keep", json::parse("[1]")},
+                  {"drop", true},
+                  {"sub", json::parse(R"({"y":1})")}}}};
+  auto to = from;
+  EXPECT_TRUE(diff(from, to).as_object().empty());
+
+  to.counts_.erase("a");
+  to.counts_["b"] = 3;
+  to.labels_.reset();
+  to.extra_->erase("drop");
+  to.extra_->at("sub") = json::parse(R"({"y":2})");
+  auto const patch = diff(from, to);
+  EXPECT_EQ(json::parse(R"({"counts":{"a":null,"b":3},"labels":null,)"
+                        R"("extra":{"drop":null,"sub":{"y":2}}})"),
+            patch);
+
+  auto x = from;
+  apply_patch(x, patch);
+  EXPECT_EQ(to, x);
+  apply_patch(x, diff(to, from));
+  EXPECT_EQ(from, x);
+
+  // additionalProperties are members of the patch itself.
+  auto const gauge =
+      pet::Gauge{.id_ = "g", .additional_ = {{"temp", 21.5}, {"hum", 40.0}}};
+  auto changed = gauge;
+  changed.additional_.erase("hum");
+  changed.additional_["wind"] = 3.0;
+  EXPECT_EQ(json::parse(R"({"hum":null,"wind":3E0})"), diff(gauge, changed));
+  auto patched = gauge;
+  apply_patch(patched, diff(gauge, changed));
+  EXPECT_EQ(changed, patched);
+
+  auto sighting = pet::Sighting{.id_ = 1, .count_ = 5};
+  apply_patch(sighting, json::parse(R"({"count":null,"name":"owl"})"));
+  EXPECT_EQ((pet::Sighting{.id_ = 1, .name_ = "owl"}), sighting);
+  EXPECT_THROW(apply_patch(sighting, json::parse(R"({"id":null})")),
+               std::exception);
+}
+
+TEST(merge_patch, unchanged_subtrees) {
+  auto const t = std::chrono::sys_seconds{std::chrono::sys_days{} + 10h};
+  auto from = transit::Plan{.from_ = make_place("Frankfurt (Main) Hbf", t),
+                            .to_ = make_place("Berlin Hbf", t + 4h)};
+  from.itineraries_.resize(100U, transit::Itinerary{.duration_ = 240,
+                                                    .startTime_ = t,
+                                                    .endTime_ = t + 4h,
+                                                    .transfers_ = 1});
+  auto to = from;
+  to.to_.name_ = "Berlin Ostbahnhof";
+
+  auto const patch = transit::encode_plan_response_patch(from, to);
+  EXPECT_EQ(R"({"to":{"name":"Berlin Ostbahnhof"}})", patch);
+  EXPECT_LT(patch.size() * 100U, transit::encode_plan_response(to).size());
+
+  apply_patch(from, json::parse(patch));
+  EXPECT_EQ(to, from);
+}
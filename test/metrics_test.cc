@@ -0,0 +1,76 @@
+#include "gtest/gtest.h"
+
+#include <sstream>
+#include <stdexcept>
+
+#include "openapi/metrics.h"
+
+#include "pet-api/pet-api.h"
+
+using namespace openapi::metrics;
+
+TEST(metrics, buckets) {
+  for (auto i = std::size_t{1U}; i != kBuckets; ++i) {
+    EXPECT_EQ(i, bucket(bucket_limit(i - 1U)));
+    EXPECT_EQ(i, bucket(bucket_limit(i) - 1U));
+  }
+  EXPECT_EQ(0U, bucket(0U));
+  EXPECT_EQ(kBuckets - 1U, bucket(std::uint64_t{1U} << 60U));
+}
+
+TEST(metrics, scope) {
+  auto& op = get("metrics_test");
+  EXPECT_EQ(&op, &get("metrics_test"));
+
+  {
+    auto s = scope{op, stage::kEncode};
+    s.bytes(42U);
+  }
+  try {
+    auto s = scope{op, stage::kDecode};
+    throw std::runtime_error{"fail"};
+  } catch (std::exception const&) {
+  }
+
+  EXPECT_EQ(1U, op.count(stage::kEncode));
+  EXPECT_EQ(42U, op.bytes(stage::kEncode));
+  EXPECT_EQ(0U, op.errors(stage::kEncode));
+  EXPECT_EQ(1U, op.count(stage::kDecode));
+  EXPECT_EQ(1U, op.errors(stage::kDecode));
+  EXPECT_EQ(0U, op.count(stage::kParams));
+
+  auto ss = std::stringstream{};
+  write_prometheus(ss);
+  auto const out = ss.str();
+  EXPECT_NE(std::string::npos,
+            out.find("# TYPE openapi_latency_seconds histogram\n"));
+  EXPECT_NE(std::string::npos,
+            out.find("openapi_latency_seconds_count{operation=\"metrics_test\","
+                     "stage=\"encode\"} 1\n"));
+  EXPECT_NE(std::string::npos,
+            out.find("openapi_bytes_total{operation=\"metrics_test\",stage="
+                     "\"encode\"} 42\n"));
+  EXPECT_NE(std::string::npos,
+            out.find("openapi_errors_total{operation=\"metrics_test\",stage="
+                     "\"decode\"} 1\n"));
+  EXPECT_EQ(std::string::npos, out.find("stage=\"params\""));
+}
+
+TEST(metrics, generated_operations) {
+  auto const p = pet::parse_findPets_params(
+      boost::urls::url_view{"/pets?limit=7"}.params());
+  EXPECT_EQ(7, p.limit_);
+
+  auto const added =
+      pet::decode_addPet_body(R"({"petType":"Dog","bark":true})");
+  EXPECT_TRUE(std::holds_alternative<pet::Dog>(added));
+
+  EXPECT_EQ(R"({"counts":{}})",
+            pet::encode_findPets_response(pet::Shelf{}));
+
+#ifdef OPENAPI_METRICS
+  EXPECT_EQ(1U, get("findPets").count(stage::kParams));
+  EXPECT_EQ(1U, get("findPets").count(stage::kEncode));
+  EXPECT_EQ(1U, get("addPet").count(stage::kDecode));
+#endif
+}
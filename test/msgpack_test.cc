@@ -0,0 +1,160 @@
+#include "gtest/gtest.h"
+
+#include <chrono>
+#include <limits>
+#include <string>
+
+#include "boost/json.hpp"
+
+#include "openapi/msgpack.h"
+
+#include "pet-api/pet-api.h"
+#include "transit-api/transit-api.h"
+
+#include "transit_fixture.h"
+
+using namespace openapi;
+using namespace openapi::test;
+using namespace std::chrono_literals;
+namespace json = boost::json;
+
+namespace {
+
+template <typename T>
+void expect_round_trip(T const& x) {
+  for (auto const keys : {msgpack_keys::kNames, msgpack_keys::kIndices}) {
+    EXPECT_EQ(x, from_msgpack<T>(to_msgpack(x, keys)));
+  }
+}
+
+}  // namespace
+
+TEST(msgpack, round_trip) {
+  expect_round_trip(pet::Item{.x_ = pet::StatusEnum::OFF,
+                              .y_ = {pet::PetsEnum::B, pet::PetsEnum::A},
+                              .z_ = -1234567});
+  expect_round_trip(pet::Item{.x_ = pet::StatusEnum::ON});
+  expect_round_trip(pet::Shelf{
+      .counts_ = {{"a", 1}, {"b", 1LL << 40}},
+      .labels_ = pet::Labels{{"z", "last"}, {"a", "first"}},
+      .extra_ = {{{"x", json::parse(R"([true,null,1.5,-3,"s"])")},
+                  {"y", json::object{}}}}});
+  expect_round_trip(pet::Gauge{.id_ = "g",
+                               .samples_ = std::vector{0.5},
+                               .additional_ = {{"temp", 21.5}, {"hum", 40.0}}});
+  expect_round_trip(pet::Pet{pet::Cat{.petType_ = "kitty", .name_ = "Tom"}});
+  expect_round_trip(pet::Pet{pet::Dog{.petType_ = "Dog", .bark_ = true}});
+  expect_round_trip(pet::Sighting{.id_ = 7,
+                                  .lat_ = 50.1,
+                                  .seen_ = false,
+                                  .status_ = pet::StatusEnum::ON});
+  expect_round_trip(pet::Reading{
+      .sensor_ = -1, .value_ = 0.1F, .level_ = 255U, .total_ = 1LL << 50});
+  expect_round_trip(make_plan(2U));
+}
+
+TEST(msgpack, date_time) {
+  using ms = std::chrono::milliseconds;
+  for (auto const t :
+       {date_time_t{std::chrono::sys_seconds{1s}},
+        date_time_t{std::chrono::sys_time<ms>{1'700'000'000'123ms}, 120min},
+        date_time_t{std::chrono::sys_time<ms>{17'179'869'184'000ms}},
+        date_time_t{std::chrono::sys_time<ms>{-86'400'001ms}, -330min}}) {
+    expect_round_trip(t);
+  }
+
+  // [timestamp 32, offset]
+  EXPECT_EQ(std::string_view("\x92\xd6\xff\x00\x00\x00\x01\x00", 8U),
+            to_msgpack(date_time_t{std::chrono::sys_seconds{1s}}));
+
+  auto bad_offset = std::string{};
+  auto w = msgpack_writer{bad_offset};
+  w.write_array(2U);
+  w.write_timestamp({0, 0U});
+  w.write_int(std::numeric_limits<std::int64_t>::min());
+  EXPECT_THROW(from_msgpack<date_time_t>(bad_offset), std::exception);
+
+  auto wrong_type = msgpack_reader{"\xd6\xfe\x00\x00\x00\x01"};
+  EXPECT_THROW(wrong_type.read_timestamp(), std::exception);
+}
+
+TEST(msgpack, keys) {
+  auto const item = pet::Item{.x_ = pet::StatusEnum::OFF,
+                              .y_ = {pet::PetsEnum::B}};
+  auto const names = to_msgpack(item);
+  auto const indices = to_msgpack(item, msgpack_keys::kIndices);
+  EXPECT_EQ(std::string_view{"\x82\xa1x\xa3OFF\xa1y\x91\xa1"
+                             "B",
+                             12U},
+            names);
+  EXPECT_EQ(std::string_view{"\x82\x00\x01\x01\x91\x01", 6U}, indices);
+
+  // Unknown keys are skipped, missing optionals are reset.
+  auto cat = pet::Cat{.petType_ = "x", .name_ = "y", .lives_ = 9};
+  msgpack_into(cat, to_msgpack(pet::Tiger{
+                        .petType_ = "t", .name_ = "Tom", .stripes_ = 3}));
+  EXPECT_EQ((pet::Cat{.petType_ = "t", .name_ = "Tom"}), cat);
+
+  EXPECT_THROW(from_msgpack<pet::Dog>(to_msgpack(cat)), std::exception);
+  EXPECT_THROW(from_msgpack<pet::Item>(names.substr(0U, 10U)), std::exception);
+
+  // Forged lengths are rejected before anything is allocated.
+  auto const huge_array = std::string_view{"\xdd\xff\xff\xff\xff\x01", 6U};
+  auto const huge_map = std::string_view{"\xdf\x7f\xff\xff\xff\xa1x", 7U};
+  EXPECT_THROW(from_msgpack<std::vector<std::int64_t>>(huge_array),
+               std::exception);
+  EXPECT_THROW(from_msgpack<json::value>(huge_array), std::exception);
+  EXPECT_THROW(from_msgpack<json::value>(huge_map), std::exception);
+  EXPECT_THROW(from_msgpack<pet::Shelf>(huge_map), std::exception);
+  EXPECT_EQ((std::vector<std::int64_t>{1}),
+            from_msgpack<std::vector<std::int64_t>>(
+                std::string_view{"\xdd\x00\x00\x00\x01\x01", 6U}));
+
+  auto reading = std::string{};
+  auto w = msgpack_writer{reading};
+  w.write_map(3U);
+  w.write_key(0U, "sensor");
+  w.write_int(1);
+  w.write_key(1U, "value");
+  w.write_double(1e300);
+  w.write_key(2U, "level");
+  w.write_uint(1U);
+  EXPECT_THROW(from_msgpack<pet::Reading>(reading), std::exception);
+}
+
+TEST(msgpack, negotiate) {
+  EXPECT_EQ(wire_format::kJson, negotiate(""));
+  EXPECT_EQ(wire_format::kJson, negotiate("*/*"));
+  EXPECT_EQ(wire_format::kMsgpack, negotiate("application/msgpack"));
+  EXPECT_EQ(wire_format::kMsgpack, negotiate("application/msgpack, */*"));
+  EXPECT_EQ(wire_format::kJson,
+            negotiate("application/json, application/x-msgpack"));
+  EXPECT_EQ(wire_format::kMsgpack,
+            negotiate("application/json;q=0.5, application/x-msgpack"));
+  EXPECT_EQ(wire_format::kJson,
+            negotiate("application/msgpack;q=0, application/*;q=0.1"));
+
+  EXPECT_EQ(wire_format::kMsgpack,
+            from_content_type("application/vnd.msgpack; charset=binary"));
+  EXPECT_EQ(wire_format::kJson, from_content_type("application/json"));
+  EXPECT_EQ(std::nullopt, from_content_type("text/html"));
+  EXPECT_EQ("application/msgpack", content_type(wire_format::kMsgpack));
+
+  auto const shelf = pet::Shelf{.counts_ = {{"a", 1}}};
+  EXPECT_EQ(to_msgpack(shelf),
+            pet::encode_findPets_response(shelf, wire_format::kMsgpack));
+  EXPECT_EQ(pet::encode_findPets_response(shelf),
+            pet::encode_findPets_response(shelf, wire_format::kJson));
+  auto const dog = pet::Pet{pet::Dog{.petType_ = "Dog", .bark_ = true}};
+  EXPECT_EQ(dog,
+            pet::decode_addPet_body(to_msgpack(dog), wire_format::kMsgpack));
+}
+
+TEST(msgpack, smaller_than_json) {
+  auto const plan = make_plan(2U);
+  auto const json_str = json::serialize(json::value_from(plan));
+  auto const names = to_msgpack(plan);
+  auto const indices = to_msgpack(plan, msgpack_keys::kIndices);
+  EXPECT_LT(names.size(), json_str.size());
+  EXPECT_LT(indices.size(), names.size());
+}
@@ -0,0 +1,69 @@
+#include "gtest/gtest.h"
+
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "boost/json.hpp"
+
+#include "openapi/parallel_encode.h"
+
+#include "pet-api/pet-api.h"
+
+#include "pet_fixture.h"
+
+using namespace openapi;
+using namespace openapi::test;
+namespace json = boost::json;
+
+TEST(parallel_encode, pool) {
+  for (auto const n_threads : {1U, 2U, 4U}) {
+    auto pool = encode_pool{n_threads};
+    EXPECT_EQ(n_threads, pool.size());
+
+    auto hits = std::vector<int>(1000U);
+    pool.run(hits.size(), [&](std::size_t const i) { ++hits[i]; });
+    EXPECT_EQ(std::vector<int>(1000U, 1), hits);
+
+    EXPECT_THROW(pool.run(100U,
+                          [](std::size_t const i) {
+                            if (i == 42U) {
+                              throw std::runtime_error{"chunk failed"};
+                            }
+                          }),
+                 std::runtime_error);
+    pool.run(0U, [](std::size_t) { FAIL(); });
+  }
+
+  // A job started while another one runs is done on the calling thread.
+  auto pool = encode_pool{2U};
+  auto outer = std::vector<int>(10U);
+  auto inner = std::vector<int>(100U);
+  pool.run(outer.size(), [&](std::size_t const i) {
+    pool.run(10U, [&](std::size_t const j) { ++inner[i * 10U + j]; });
+    ++outer[i];
+  });
+  EXPECT_EQ(std::vector<int>(10U, 1), outer);
+  EXPECT_EQ(std::vector<int>(100U, 1), inner);
+}
+
+TEST(parallel_encode, same_output) {
+  auto pool = encode_pool{4U};
+  auto const opt = parallel_encode_options{.threshold_ = 0U, .chunk_size_ = 7U};
+  for (auto const n : {0U, 1U, 7U, 8U, 100U}) {
+    auto const items = make_items(n);
+    auto const expected = json::serialize(json::value_from(items));
+
+    auto const chunks = encode_array_chunks(items, pool, opt);
+    EXPECT_EQ(n <= 7U ? 1U : (n + 6U) / 7U, chunks.size());
+    EXPECT_EQ(expected, encode_array(items, pool, opt));
+    EXPECT_EQ(expected.size(), total_size(chunks));
+  }
+
+  auto const items = make_items(10'000U);
+  EXPECT_EQ(json::serialize(json::value_from(items)),
+            pet::encode_getItems_response(items, pool));
+  EXPECT_EQ(pet::encode_getItems_response(items),
+            pet::encode_getItems_response(items, pool));
+  EXPECT_LT(1U, pet::encode_getItems_response_chunks(items, pool).size());
+}
@@ -12,26 +12,53 @@ TEST(openapi, date) {
   auto d = date_time_t{};
 
   parse("2009-06-30T18:30:00+02:00", d);
-  EXPECT_EQ(date::sys_days{2009_y / June / 30} + 16h + 30min, d.time_);
-  EXPECT_EQ(2h, d.offset_);
+  EXPECT_EQ(date::sys_days{2009_y / June / 30} + 16h + 30min, d.time());
+  EXPECT_EQ(2h, d.offset());
 
   parse("2009-06-30T18:30:00.000-02:00", d);
-  EXPECT_EQ(date::sys_days{2009_y / June / 30} + 20h + 30min, d.time_);
-  EXPECT_EQ(-2h, d.offset_);
+  EXPECT_EQ(date::sys_days{2009_y / June / 30} + 20h + 30min, d.time());
+  EXPECT_EQ(-2h, d.offset());
 
   parse("2009-06-30T16:30Z", d);
-  EXPECT_EQ(date::sys_days{2009_y / June / 30} + 16h + 30min, d.time_);
-  EXPECT_EQ(0h, d.offset_);
+  EXPECT_EQ(date::sys_days{2009_y / June / 30} + 16h + 30min, d.time());
+  EXPECT_EQ(0h, d.offset());
 
   parse("2009-06-30T20:30Z", d);
-  EXPECT_EQ(date::sys_days{2009_y / June / 30} + 20h + 30min, d.time_);
-  EXPECT_EQ(0h, d.offset_);
+  EXPECT_EQ(date::sys_days{2009_y / June / 30} + 20h + 30min, d.time());
+  EXPECT_EQ(0h, d.offset());
 
   parse("2009-06-30T16:30:00.000Z", d);
-  EXPECT_EQ(date::sys_days{2009_y / June / 30} + 16h + 30min, d.time_);
-  EXPECT_EQ(0h, d.offset_);
+  EXPECT_EQ(date::sys_days{2009_y / June / 30} + 16h + 30min, d.time());
+  EXPECT_EQ(0h, d.offset());
 
   parse("2009-06-30T20:30:00.000Z", d);
-  EXPECT_EQ(date::sys_days{2009_y / June / 30} + 20h + 30min, d.time_);
-  EXPECT_EQ(0h, d.offset_);
-}
\ No newline at end of file
+  EXPECT_EQ(date::sys_days{2009_y / June / 30} + 20h + 30min, d.time());
+  EXPECT_EQ(0h, d.offset());
+}
+TEST(openapi, date_precision) {
+  static_assert(sizeof(date_time_t) == sizeof(std::int64_t));
+
+  auto d = date_time_t{};
+  parse("2009-06-30T18:30:00.123Z", d);
+  EXPECT_EQ(date::sys_days{2009_y / June / 30} + 18h + 30min + 123ms,
+            d.time());
+  EXPECT_EQ("2009-06-30T18:30:00.123Z", to_str(d));
+  EXPECT_EQ(date::sys_days{2009_y / June / 30} + 18h + 30min, *d);
+
+  for (auto const s :
+       {"2009-06-30T18:30:00Z", "2009-06-30T18:30:00.001+02:00",
+        "1969-12-31T23:59:59.999-00:30", "2009-06-30T18:30:05+14:00"}) {
+    parse(s, d);
+    EXPECT_EQ(s, to_str(d));
+    auto copy = date_time_t{};
+    parse(to_str(d), copy);
+    EXPECT_EQ(d, copy);
+    EXPECT_EQ(d.hash(), copy.hash());
+  }
+
+  auto const t = date::sys_days{2009_y / June / 30} + 18h;
+  EXPECT_LT(date_time_t{t}, date_time_t{t + 1ms});
+  EXPECT_LT(date_time_t{t - 1ms, 60min}, date_time_t{t});
+  EXPECT_NE(date_time_t{t}, date_time_t(t, 60min));
+  EXPECT_THROW(date_time_t(t, 2048min), std::runtime_error);
+}
@@ -0,0 +1,23 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "pet-api/pet-api.h"
+
+namespace openapi::test {
+
+inline std::vector<pet::Item> make_items(std::size_t const n) {
+  auto items = std::vector<pet::Item>{};
+  items.reserve(n);
+  for (auto i = std::size_t{0U}; i != n; ++i) {
+    items.push_back(pet::Item{
+        .x_ = i % 2U == 0U ? pet::StatusEnum::ON : pet::StatusEnum::OFF,
+        .y_ = {pet::PetsEnum::A, pet::PetsEnum::B},
+        .z_ = static_cast<std::int64_t>(i)});
+  }
+  return items;
+}
+
+}  // namespace openapi::test
@@ -0,0 +1,92 @@
+#include "gtest/gtest.h"
+
+#include <chrono>
+#include <string>
+
+#include "boost/json.hpp"
+
+#include "openapi/load_spec.h"
+#include "openapi/schema_vm.h"
+
+#include "transit-api/transit-api.h"
+
+#include "transit_fixture.h"
+
+using namespace openapi;
+using namespace openapi::test;
+using namespace std::chrono_literals;
+namespace json = boost::json;
+
+namespace {
+
+YAML::Node const& pet_spec() {
+  static auto const spec = load_spec(OPENAPI_TEST_DIR "/pet.yml");
+  return spec;
+}
+
+}  // namespace
+
+TEST(schema_vm, validate) {
+  auto const item = compile_schema(pet_spec(), "Item");
+  EXPECT_EQ(std::nullopt, validate(item, R"({"x":"ON","y":["A","B"],"z":3})"));
+  EXPECT_EQ(std::nullopt, validate(item, R"({"x":"ON","y":[],"more":[1]})"));
+  EXPECT_EQ("/y/1: expected one of A, B, got \"C\"",
+            validate(item, R"({"x":"ON","y":["A","C"]})"));
+  EXPECT_EQ("/: missing property y", validate(item, R"({"x":"OFF"})"));
+  EXPECT_EQ("/z: expected integer in range, got 1.5",
+            validate(item, R"({"x":"ON","y":[],"z":1.5})"));
+
+  auto const reading = compile_schema(pet_spec(), "Reading");
+  EXPECT_EQ(std::nullopt,
+            validate(reading, R"({"sensor":1,"value":0.5,"level":255})"));
+  EXPECT_EQ("/level: expected integer in range, got 256",
+            validate(reading, R"({"sensor":1,"value":0.5,"level":256})"));
+  EXPECT_EQ("/value: expected float in range, got 1e+300",
+            validate(reading, R"({"sensor":1,"value":1e300,"level":0})"));
+}
+
+TEST(schema_vm, variants) {
+  auto const pet = compile_schema(pet_spec(), "Pet");
+  EXPECT_EQ(std::nullopt,
+            validate(pet, R"({"petType":"kitty","name":"Tom","lives":9})"));
+  EXPECT_EQ(std::nullopt, validate(pet, R"({"bark":true,"petType":"Dog"})"));
+  EXPECT_EQ("/: missing property bark",
+            validate(pet, R"({"petType":"Dog","name":"Rex"})"));
+  EXPECT_EQ("/: petType not found", validate(pet, R"({"bark":true})"));
+
+  auto const animal = compile_schema(pet_spec(), "Animal");
+  EXPECT_EQ(std::nullopt, validate(animal, R"({"petType":"x","name":"Tom"})"));
+  EXPECT_EQ("/: no alternative matches", validate(animal, R"({"name":"Tom"})"));
+
+  EXPECT_EQ(R"({"petType":"kitty","name":"Tom"})",
+            filter(pet, R"({"petType":"kitty","name":"Tom","x":{"y":[1]}})"));
+}
+
+TEST(schema_vm, filter_and_normalize) {
+  auto const tiger = compile_schema(pet_spec(), "Tiger");
+  EXPECT_EQ(R"({"petType":"t","name":"Tom","stripes":3})",
+            filter(tiger, R"({"petType":"t","a":[{}],"name":"Tom",)"
+                          R"("stripes":3,"b":"\"c\""})"));
+  EXPECT_EQ(R"({"petType":"t","name":"Tom","stripes":3})",
+            normalize(tiger, R"({"petType":"t","name":"Tom","stripes":3.0})"));
+  EXPECT_THROW(filter(tiger, R"({"petType":"t","name":"Tom"})"),
+               std::exception);
+
+  auto const reading = compile_schema(pet_spec(), "Reading");
+  EXPECT_EQ(R"({"sensor":1,"value":0.10000000149011612,"level":2})",
+            normalize(reading, R"({"sensor":1,"value":0.1,"level":2})"));
+
+  auto const shelf = compile_schema(pet_spec(), "Shelf");
+  EXPECT_EQ(R"({"counts":{"a":1},"extra":{"x":[true,null]}})",
+            filter(shelf, R"({"counts":{"a":1},"extra":{"x":[true,null]}})"));
+}
+
+TEST(schema_vm, generated_plan) {
+  auto const spec = load_spec(OPENAPI_TEST_DIR "/transit.yml");
+  auto const program = compile_schema(spec, "Plan");
+  auto const plan = make_plan(2U);
+  auto const str = json::serialize(json::value_from(plan));
+  EXPECT_EQ(std::nullopt, validate(program, str));
+  auto const normalized = normalize(program, str);
+  EXPECT_EQ(plan, json::value_to<transit::Plan>(json::parse(normalized)));
+}
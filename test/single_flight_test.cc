@@ -0,0 +1,143 @@
+#include "gtest/gtest.h"
+
+#include <atomic>
+#include <chrono>
+#include <latch>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "openapi/single_flight.h"
+
+#include "pet-api/pet-api.h"
+
+using namespace openapi;
+using namespace std::chrono_literals;
+
+namespace {
+
+pet::findPets_params make_params(std::int64_t const limit) {
+  auto p = pet::findPets_params{};
+  p.limit_ = limit;
+  return p;
+}
+
+// Blocks the computation until release() to keep the flight open.
+struct gate {
+  std::string operator()() {
+    started_.count_down();
+    release_.wait();
+    if (fail_) {
+      throw std::runtime_error{"computation failed"};
+    }
+    return "shared";
+  }
+
+  std::latch started_{1};
+  std::latch release_{1};
+  bool fail_{false};
+};
+
+template <typename Params>
+void wait_for_calls(single_flight<Params> const& sf, std::uint64_t const n) {
+  while (sf.stats().calls_ != n) {
+    std::this_thread::yield();
+  }
+}
+
+}  // namespace
+
+TEST(single_flight, params_hash) {
+  auto a = make_params(10);
+  auto b = make_params(10);
+  EXPECT_TRUE(members_equal(a, b));
+  EXPECT_EQ(members_hash(a), members_hash(b));
+
+  b.status_ = pet::StatusEnumSet{pet::StatusEnum::ON};
+  EXPECT_FALSE(members_equal(a, b));
+  EXPECT_NE(members_hash(a), members_hash(b));
+}
+
+TEST(single_flight, coalesce) {
+  auto sf = single_flight<pet::findPets_params>{};
+  auto const params = make_params(10);
+  auto computations = std::atomic_uint{0U};
+
+  auto g = gate{};
+  auto leader = std::thread{[&] {
+    sf.run(params, [&] {
+      ++computations;
+      return g();
+    });
+  }};
+  g.started_.wait();
+
+  auto results = std::vector<single_flight<pet::findPets_params>::result_t>(8U);
+  auto waiters = std::vector<std::thread>{};
+  for (auto& r : results) {
+    waiters.emplace_back([&] {
+      r = sf.run(params, [&] {
+        ++computations;
+        return std::string{"own"};
+      });
+    });
+  }
+  wait_for_calls(sf, 9U);
+  EXPECT_EQ(1U, sf.in_flight());
+
+  g.release_.count_down();
+  leader.join();
+  for (auto& w : waiters) {
+    w.join();
+  }
+
+  EXPECT_EQ(1U, computations);
+  EXPECT_EQ(8U, sf.stats().coalesced_);
+  EXPECT_EQ(0U, sf.in_flight());
+  for (auto const& r : results) {
+    EXPECT_EQ(results.front(), r);
+    EXPECT_EQ("shared", *r);
+  }
+
+  // Finished flights are not cached.
+  EXPECT_EQ("new", *sf.run(params, [] { return std::string{"new"}; }));
+}
+
+TEST(single_flight, errors) {
+  auto sf = single_flight<pet::findPets_params>{};
+  auto const params = make_params(1);
+
+  auto g = gate{.fail_ = true};
+  auto leader = std::thread{[&] {
+    EXPECT_THROW(sf.run(params, std::ref(g)), std::runtime_error);
+  }};
+  g.started_.wait();
+
+  auto waiter = std::thread{[&] {
+    EXPECT_THROW(sf.run(params, [] { return std::string{"own"}; }),
+                 std::runtime_error);
+  }};
+  wait_for_calls(sf, 2U);
+  g.release_.count_down();
+  leader.join();
+  waiter.join();
+  EXPECT_EQ(0U, sf.in_flight());
+}
+
+TEST(single_flight, timeout) {
+  auto sf = single_flight<pet::findPets_params>{10ms};
+  auto const params = make_params(1);
+
+  auto g = gate{};
+  auto leader = std::thread{[&] { sf.run(params, std::ref(g)); }};
+  g.started_.wait();
+
+  EXPECT_EQ("own", *sf.run(params, [] { return std::string{"own"}; }));
+  EXPECT_EQ(1U, sf.stats().timeouts_);
+  EXPECT_EQ(0U, sf.stats().coalesced_);
+
+  g.release_.count_down();
+  leader.join();
+}
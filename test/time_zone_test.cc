@@ -0,0 +1,70 @@
+#include "gtest/gtest.h"
+
+#include <thread>
+#include <vector>
+
+#include "date/date.h"
+
+#include "openapi/time_zone.h"
+
+using namespace std::chrono_literals;
+using namespace date::literals;
+using namespace openapi;
+
+TEST(time_zone, render) {
+  auto const summer =
+      date_time_t{date::sys_days{2024_y / date::July / 1} + 10h};
+  auto const winter =
+      date_time_t{date::sys_days{2024_y / date::January / 1} + 10h};
+
+  EXPECT_EQ("2024-07-01T12:00:00+02:00", to_str(summer, "Europe/Berlin"));
+  EXPECT_EQ("2024-01-01T11:00:00+01:00", to_str(winter, "Europe/Berlin"));
+  EXPECT_EQ("2024-07-01T06:00:00-04:00", to_str(summer, "America/New_York"));
+  EXPECT_EQ("2024-07-01T15:30:00+05:30", to_str(summer, "Asia/Kolkata"));
+  EXPECT_EQ("2024-07-01T10:00:00Z", to_str(summer, "UTC"));
+
+  auto const berlin = time_zone{"Europe/Berlin"};
+  EXPECT_EQ(berlin.tz_, time_zone{"Europe/Berlin"}.tz_);
+  // Same instant, different offset (date_time_t compares both).
+  EXPECT_EQ(summer.time(), berlin.to_local(summer).time());
+  EXPECT_EQ(120min, berlin.to_local(summer).offset());
+  EXPECT_NE(summer, berlin.to_local(summer));
+  EXPECT_EQ("2024-01-01T10:00:00Z", to_str(winter, "Europe/London"));
+
+  // Around the DST switch (2024-03-31 01:00 UTC).
+  auto const dst = date::sys_days{2024_y / date::March / 31} + 1h;
+  EXPECT_EQ(60min, berlin.offset(dst - 1ms));
+  EXPECT_EQ(120min, berlin.offset(dst));
+  EXPECT_EQ(60min, berlin.offset(dst - 1ms));
+
+  EXPECT_THROW(time_zone{"Mars/Olympus_Mons"}, std::runtime_error);
+}
+
+TEST(time_zone, concurrent) {
+  auto const zones = std::vector<std::string>{
+      "Europe/Berlin", "America/New_York", "Asia/Tokyo", "Australia/Sydney"};
+  auto const start = date::sys_days{2024_y / date::January / 1};
+
+  auto expected = std::vector<std::string>{};
+  for (auto i = 0U; i != 1000U; ++i) {
+    expected.emplace_back(
+        to_str(date_time_t{start + i * 9h}, zones[i % zones.size()]));
+  }
+
+  auto threads = std::vector<std::thread>{};
+  auto mismatches = std::vector<unsigned>(4U);
+  for (auto t = 0U; t != 4U; ++t) {
+    threads.emplace_back([&, t]() {
+      for (auto i = 0U; i != 1000U; ++i) {
+        if (to_str(date_time_t{start + i * 9h}, zones[i % zones.size()]) !=
+            expected[i]) {
+          ++mismatches[t];
+        }
+      }
+    });
+  }
+  for (auto& t : threads) {
+    t.join();
+  }
+  EXPECT_EQ((std::vector<unsigned>(4U)), mismatches);
+}
@@ -0,0 +1,109 @@
+#pragma once
+
+#include <array>
+#include <chrono>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "openapi/date_time.h"
+
+#include "transit-api/transit-api.h"
+
+namespace openapi::test {
+
+inline transit::Place make_place(std::string name,
+                                 std::chrono::sys_seconds const t) {
+  using namespace std::chrono_literals;
+  return {.name_ = std::move(name),
+          .stopId_ = "de:06412:10",
+          .lat_ = 50.107,
+          .lon_ = 8.663,
+          .vertexType_ = transit::VertexTypeEnum::TRANSIT,
+          .arrival_ = date_time_t{t},
+          .departure_ = date_time_t{t + 2min},
+          .track_ = "7"};
+}
+
+// n itineraries of 2 legs with 3 places each (from, to, one intermediate
+// stop). The per-itinerary allocation budgets in alloc_budget_test.cc are
+// derived from this shape.
+inline transit::Plan make_plan(unsigned const n_itineraries) {
+  using namespace std::chrono_literals;
+  auto const t = std::chrono::sys_seconds{std::chrono::sys_days{} + 10h};
+  auto plan = transit::Plan{
+      .from_ = make_place("Frankfurt (Main) Hauptbahnhof", t),
+      .to_ = make_place("Berlin Hauptbahnhof (tief)", t + 4h)};
+  for (auto i = 0U; i != n_itineraries; ++i) {
+    auto& it = plan.itineraries_.emplace_back(
+        transit::Itinerary{.duration_ = 240,
+                           .startTime_ = t,
+                           .endTime_ = t + 4h,
+                           .transfers_ = 1});
+    for (auto j = 0U; j != 2U; ++j) {
+      it.legs_.push_back(transit::Leg{
+          .mode_ = transit::ModeEnum::RAIL,
+          .from_ = make_place("Frankfurt (Main) Hauptbahnhof", t),
+          .to_ = make_place("Erfurt Hauptbahnhof Gleis 10", t + 2h),
+          .duration_ = 120,
+          .startTime_ = t,
+          .endTime_ = t + 2h,
+          .realTime_ = true,
+          .headsign_ = "Berlin Hauptbahnhof (tief)",
+          .agencyName_ = "DB Fernverkehr AG",
+          .agencyId_ = "dbfv",
+          .routeShortName_ = "ICE 1234",
+          .tripId_ = "20240101_10:00_ICE_1234",
+          .intermediateStops_ = std::vector{make_place("Fulda", t + 1h)},
+          .legGeometry_ = {.points_ = {50.107, 8.663, 50.554, 9.684, 50.972,
+                                       11.038},
+                           .length_ = 3}});
+    }
+  }
+  return plan;
+}
+
+// Realistic repetition: few agencies / routes, a few hundred stops.
+inline transit::Plan make_city_plan() {
+  using namespace std::chrono_literals;
+  auto const agencies = std::array{"DB Fernverkehr AG", "DB Regio AG Hessen",
+                                    "Rhein-Main-Verkehrsverbund GmbH",
+                                    "Verkehrsgesellschaft Frankfurt am Main"};
+  auto const t = std::chrono::sys_seconds{std::chrono::sys_days{} + 10h};
+  auto const place = [&](unsigned const i) {
+    return transit::Place{
+        .name_ = "Frankfurt (Main) Haltestelle Nummer " + std::to_string(i),
+        .stopId_ = "de:06412:" + std::to_string(10000U + i),
+        .lat_ = 50.1,
+        .lon_ = 8.6,
+        .vertexType_ = transit::VertexTypeEnum::TRANSIT};
+  };
+
+  auto plan = transit::Plan{.from_ = place(0U), .to_ = place(1U)};
+  for (auto i = 0U; i != 500U; ++i) {
+    auto& it = plan.itineraries_.emplace_back(
+        transit::Itinerary{.duration_ = 60,
+                           .startTime_ = t,
+                           .endTime_ = t + 1h,
+                           .transfers_ = 2});
+    for (auto j = 0U; j != 3U; ++j) {
+      auto const route = (i + j) % 12U;
+      it.legs_.push_back(transit::Leg{
+          .mode_ = transit::ModeEnum::BUS,
+          .from_ = place((i * 7U + j) % 300U),
+          .to_ = place((i * 11U + j) % 300U),
+          .duration_ = 20,
+          .startTime_ = t,
+          .endTime_ = t + 20min,
+          .headsign_ = "Richtung Frankfurt (Main) Hauptbahnhof Linie " +
+                       std::to_string(route),
+          .agencyName_ = agencies[route % agencies.size()],
+          .agencyId_ = "agency-" + std::to_string(route % agencies.size()),
+          .routeShortName_ = std::to_string(route),
+          .legGeometry_ = {.points_ = {50.1, 8.6}, .length_ = 1}});
+    }
+  }
+  return plan;
+}
+
+}  // namespace openapi::test